@@ -7,6 +7,8 @@
 #include<vector>
 #include<stdlib.h>
 
+#include "GZip.h"
+
 using namespace std;
 
 /* Convert one type to any other type */
@@ -59,6 +61,9 @@ int main(int argc, char* argv[]) {
 	input_filename = argv[1];
 	output_filename = argv[2];	
 
+	//Decompress the blocks of BGZF input on all cores
+	TaskGroup::setThreads(thread::hardware_concurrency());
+
 	FileContent.clear();
 	sequence.clear();
 
@@ -72,11 +77,14 @@ int convertFile(string input_filename) {
 	int i,j, flag=1;;	
 
 	try {		
-		ifstream is(input_filename.c_str());
-		if (!is) {
+		//Plain or gzip input
+		string content = "";
+		if (!GZip::readFile(input_filename, content)) {
 			cout<<"Error in opening file..."<<endl;
 			throw 1;
 		}
+		istringstream is(content);
+		content = "";
 		
 		//Read the file's content saved in the vector of FileContent
 		cout<<"Reading sequences..."<<endl;
@@ -86,7 +94,6 @@ int convertFile(string input_filename) {
 			FileContent.push_back(temp);
 			temp = "";
 		}
-		is.close();
 		is.clear();	
 
 		//Parse FileContent and convert to axt file
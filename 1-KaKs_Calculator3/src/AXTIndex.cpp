@@ -0,0 +1,191 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: AXTIndex.cpp
+* Abstract: Definition of an index of the byte offsets of
+			records in axt file, for reading a slice of the
+			records without reading the file from the start.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+
+#include "AXTIndex.h"
+#include "AXTReader.h"
+#include<stdio.h>
+
+AXTIndex::AXTIndex() {
+	file_size = -1;
+}
+
+string AXTIndex::getIndexName(string axt_filename) {
+	return axt_filename + AXTINDEX_SUFFIX;
+}
+
+long long AXTIndex::getFileSize(string filename) {
+
+	ifstream is(filename.c_str(), ios::binary);
+	if (!is) return -1;
+	is.seekg(0, ios::end);
+
+	return (long long)is.tellg();
+}
+
+/****************************************************
+* Function: build
+* Input Parameter: string
+* Output: Scan axt file and record the offset of each
+		  record, i.e. a name line, sequence lines and
+		  a blank line, as read by 'readAXTSeq'.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool AXTIndex::build(string axt_filename) {
+
+	bool flag = true;
+	offsets.clear();
+
+	try {
+		AXTReader axt;
+		if (!axt.open(axt_filename)) {
+			cout << "Error in opening file..." << endl;
+			throw 1;
+		}
+
+		AXTRecord rec;
+		long long pos = 0;
+		while (axt.next(rec)) {
+			offsets.push_back(pos);
+			pos = rec.end;
+		}
+		if (axt.isFailed()) throw 1;
+		axt.close();
+
+		file_size = getFileSize(axt_filename);
+	}
+	catch (...) {
+		flag = false;
+	}
+
+	return flag;
+}
+
+/****************************************************
+* Function: load
+* Input Parameter: string
+* Output: Read the index saved along axt file. When it
+		  is missing or the size of axt file changed,
+		  the file is scanned instead.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool AXTIndex::load(string axt_filename) {
+
+	bool flag = true;
+	offsets.clear();
+
+	try {
+		long long size = getFileSize(axt_filename);
+		if (size < 0) {
+			cout << "Error in opening file..." << endl;
+			throw 1;
+		}
+
+		ifstream is(getIndexName(axt_filename).c_str());
+		string header = "";
+		unsigned long n = 0;
+		file_size = -1;
+		if (is) is >> header >> file_size >> n;
+
+		if (header != AXTINDEX_HEADER || file_size != size) {
+			cout << "No index up to date for " << axt_filename << ", scanning it (";
+			cout << AXTINDEX_NAME << " saves one)..." << endl;
+			if (!build(axt_filename)) throw 1;
+		}
+		else {
+			long long offset;
+			offsets.reserve(n);
+			while (offsets.size() < n && is >> offset) offsets.push_back(offset);
+			if (offsets.size() != n) {
+				cout << "Error in reading index file..." << endl;
+				throw 1;
+			}
+		}
+	}
+	catch (...) {
+		flag = false;
+	}
+
+	return flag;
+}
+
+/****************************************************
+* Function: save
+* Input Parameter: string
+* Output: Write a header with the size of axt file and
+		  the number of records, and then the offsets.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool AXTIndex::save(string index_filename) {
+
+	bool flag = true;
+
+	try {
+		ofstream os(index_filename.c_str());
+		if (!os) {
+			cout << "Error in writing file..." << endl;
+			throw 1;
+		}
+
+		os << AXTINDEX_HEADER << "\t" << file_size << "\t" << offsets.size() << endl;
+		for (unsigned long i = 0; i < offsets.size(); i++) os << offsets[i] << '\n';
+
+		os.close();
+		if (!os) throw 1;
+	}
+	catch (...) {
+		flag = false;
+	}
+
+	return flag;
+}
+
+/****************************************************
+* Function: select
+* Input Parameter: string, string, unsigned long, unsigned long
+* Output: Get the records from first to last (excluded)
+		  by shard "i/N", the i-th of N nearly equal
+		  parts, or by records "a-b", both counted from 1.
+		  All records are selected if neither is given.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool AXTIndex::select(string shard, string records, unsigned long &first, unsigned long &last) {
+
+	bool flag = true;
+	unsigned long n = offsets.size();
+	first = 0;
+	last = n;
+
+	try {
+		unsigned long a, b;
+		char c;
+		if (shard != "" && records != "") throw 1;
+
+		if (shard != "") {
+			if (sscanf(shard.c_str(), "%lu/%lu%c", &a, &b, &c) != 2 || a < 1 || a > b) throw 1;
+			//floor(n*(a-1)/b) and floor(n*a/b), without overflow
+			first = n / b * (a - 1) + n % b * (a - 1) / b;
+			last = n / b * a + n % b * a / b;
+		}
+		else if (records != "") {
+			if (sscanf(records.c_str(), "%lu-%lu%c", &a, &b, &c) != 2 || a < 1 || a > b) throw 1;
+			first = a - 1 < n ? a - 1 : n;
+			last = b < n ? b : n;
+		}
+	}
+	catch (...) {
+		cout << "Error in selecting records: " << shard << records << endl;
+		flag = false;
+	}
+
+	return flag;
+}
@@ -0,0 +1,57 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: AXTIndex.h
+* Abstract: Declaration of an index of the byte offsets of
+			records in axt file, for reading a slice of the
+			records without reading the file from the start.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+#if !defined(AXTINDEX_H)
+#define  AXTINDEX_H
+
+#include<string>
+#include<iostream>
+#include<sstream>
+#include<fstream>
+#include<vector>
+#include<stdlib.h>
+
+using namespace std;
+
+#define AXTINDEX_NAME "AXTIndex"
+#define AXTINDEX_SUFFIX ".idx"
+#define AXTINDEX_HEADER "#AXTIndex"
+
+/* Byte offsets of the records in axt file */
+class AXTIndex {
+
+public:
+	AXTIndex();
+
+	/* Scan axt file for the offset of each record */
+	bool build(string axt_filename);
+	/* Read the index saved along axt file, or build it when missing or out of date */
+	bool load(string axt_filename);
+	/* Write the index into file */
+	bool save(string index_filename);
+
+	/* Get the records [first, last) selected by shard "i/N" or records "a-b" */
+	bool select(string shard, string records, unsigned long &first, unsigned long &last);
+
+	/* Name of index file saved along axt file */
+	static string getIndexName(string axt_filename);
+	/* Size of a file in bytes, -1 if it can not be opened */
+	static long long getFileSize(string filename);
+
+public:
+	/* Size of axt file when indexed, for finding an index out of date */
+	long long file_size;
+	/* Byte offset of each record, i.e. of its name line */
+	vector<long long> offsets;
+};
+
+#endif
@@ -0,0 +1,39 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: AXTIndex_main.cpp
+* Abstract: Save the byte offsets of records in axt file, so
+			that KaKs and KnKs with '--shard' or '--records'
+			seek to their records directly.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+
+#include "AXTIndex.h"
+
+int main(int argc, const char* argv[]) {
+
+	try {
+		if (argc != 2) {
+			cout << "Usage: " << AXTINDEX_NAME << " <axt file>\t//save the index to <axt file>" << AXTINDEX_SUFFIX << endl;
+			cout << "Example:" << endl;
+			cout << "\t" << AXTINDEX_NAME << " test.axt\t//save the index to test.axt" << AXTINDEX_SUFFIX << endl;
+			cout << "\t" << "KaKs -i test.axt -o test.axt.kaks.3 --shard 3/200\t//then calculate the 3rd of 200 shards" << endl;
+			throw 1;
+		}
+
+		string axt_filename = argv[1];
+		string index_filename = AXTIndex::getIndexName(axt_filename);
+
+		AXTIndex index;
+		if (!index.build(axt_filename) || !index.save(index_filename)) throw 1;
+
+		cout << "Indexed " << index.offsets.size() << " records of " << axt_filename << " into " << index_filename << endl;
+	}
+	catch (...) {
+
+	}
+	return 0;
+}
@@ -0,0 +1,161 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: AXTReader.cpp
+* Abstract: Definition of a reader of axt file mapped into
+			memory, giving records as views into the file.
+			gzip and BGZF files are decompressed as they are read.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+
+#include "AXTReader.h"
+
+#include<string.h>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+
+void AXTRecord::join(string &str) const {
+
+	str = "";
+	str.reserve(length);
+	for (int i = 0; i < lines.size(); i++) str.append(lines[i].data(), lines[i].length());
+}
+
+AXTReader::AXTReader() {
+	data = map = NULL;
+	size = pos = mapped = 0;
+	zipped = false;
+}
+
+AXTReader::~AXTReader() {
+	close();
+}
+
+/****************************************************
+* Function: open
+* Input Parameter: string
+* Output: Map the file into memory for reading. A file
+		  which can not be mapped, e.g. a pipe or an empty
+		  file, is read into memory instead. A gzip file is
+		  decompressed by its own threads ahead of 'next'.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool AXTReader::open(string filename) {
+
+	close();
+
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat st;
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p != MAP_FAILED) {
+			madvise(p, st.st_size, MADV_SEQUENTIAL);
+			data = map = (const char*)p;
+			size = mapped = st.st_size;
+		}
+	}
+	::close(fd);
+
+	if (mapped == 0) {
+		ifstream is(filename.c_str(), ios::binary);
+		if (!is) return false;
+		buffer.assign(istreambuf_iterator<char>(is), istreambuf_iterator<char>());
+		data = buffer.data();
+		size = buffer.length();
+	}
+
+	if (GZip::isGzip(data, size)) {
+		if (!gz.open(data, size)) {
+			close();
+			return false;
+		}
+		data = gz.getData();
+		size = gz.getSize();
+		zipped = true;
+	}
+
+	return true;
+}
+
+void AXTReader::close() {
+
+	//The compressed content is read until the blocks running finish
+	gz.close();
+	zipped = false;
+
+	if (mapped > 0) munmap((void*)map, mapped);
+	buffer = "";
+	data = map = NULL;
+	size = pos = mapped = 0;
+}
+
+void AXTReader::seek(long long offset) {
+	pos = offset < size ? offset : size;
+	if (zipped) gz.seek(pos);
+}
+
+void AXTReader::release() {
+	if (zipped) gz.release(pos);
+}
+
+bool AXTReader::getLine(string_view &line) {
+
+	//Content ready to read, all of it unless being decompressed
+	size_t end = zipped ? gz.available(pos) : size;
+	if (pos >= end) {
+		line = string_view();
+		return false;
+	}
+
+	const char *p = (const char*)memchr(data + pos, '\n', end - pos);
+	while (p == NULL && end < size) {
+		size_t from = end;
+		end = gz.available(from);
+		if (end <= from) break;
+		p = (const char*)memchr(data + from, '\n', end - from);
+	}
+	size_t n = p ? p - (data + pos) : end - pos;
+	line = string_view(data + pos, n);
+	pos += p ? n + 1 : n;
+
+	return true;
+}
+
+/****************************************************
+* Function: next
+* Input Parameter: AXTRecord
+* Output: Read a name line, then sequence lines until a
+		  blank line or the end of file.
+* Return Value: True if a record is read, otherwise false.
+*****************************************************/
+bool AXTReader::next(AXTRecord &rec) {
+
+	rec.lines.clear();
+	rec.length = 0;
+	rec.kept = !zipped;
+
+	release();
+	if (!getLine(rec.name)) return false;
+
+	string_view line;
+	getLine(line);
+	while (line.length() > 0) {
+		rec.lines.push_back(line);
+		rec.length += line.length();
+		getLine(line);
+	}
+	rec.end = pos;
+
+	return true;
+}
+
+bool AXTReader::isFailed() {
+	return zipped && gz.isFailed();
+}
@@ -0,0 +1,85 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: AXTReader.h
+* Abstract: Declaration of a reader of axt file mapped into
+			memory, giving records as views into the file.
+			gzip and BGZF files are decompressed as they are read.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+#if !defined(AXTREADER_H)
+#define  AXTREADER_H
+
+#include<string>
+#include<string_view>
+#include<iostream>
+#include<fstream>
+#include<vector>
+
+#include "GZip.h"
+
+using namespace std;
+
+/* A record of axt file: a name line, sequence lines and a blank line */
+struct AXTRecord {
+	/* Name line */
+	string_view name;
+	/* Sequence lines, both sequences of the pair one after the other */
+	vector<string_view> lines;
+	/* Total length of the sequence lines */
+	unsigned long length;
+	/* Byte offset of the file after the record */
+	long long end;
+	/* Whether the views stay valid after the next record, not so
+	   for compressed files whose content is freed as it is read */
+	bool kept;
+
+	/* Join the sequence lines into one string */
+	void join(string &str) const;
+};
+
+/* Records of axt file, read as 'readAXTSeq' does but without copying.
+   Readers of other formats give their pairs as records by 'next' */
+class AXTReader {
+
+public:
+	AXTReader();
+	virtual ~AXTReader();
+
+	/* Map the file into memory, or read it if it can not be mapped.
+	   Compressed content is read as it is decompressed */
+	bool open(string filename);
+	/* Unmap the file; the views of records are no longer valid */
+	void close();
+
+	/* Go to a byte offset, e.g. of a record in the index */
+	virtual void seek(long long offset);
+	/* Get the next record, false at the end of file */
+	virtual bool next(AXTRecord &rec);
+	/* Whether decompressing the file failed before its end */
+	virtual bool isFailed();
+
+protected:
+	/* Get the next line as getline does, empty at the end of file */
+	bool getLine(string_view &line);
+	/* Let the content before the current offset be freed, as nothing views it */
+	void release();
+
+	/* Content of the file, decompressed if it is gzip */
+	const char *data;
+	size_t size;
+	/* Current offset */
+	size_t pos;
+	/* The mapping and its length, 0 if the file is in 'buffer' */
+	const char *map;
+	size_t mapped;
+	string buffer;
+	/* Content of gzip file, decompressed ahead of the reader */
+	GZip gz;
+	bool zipped;
+};
+
+#endif
@@ -0,0 +1,223 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: AsyncWriter.cpp
+* Abstract: Definition of an output file written by its own
+			thread in large blocks, flushed every few seconds,
+			at exit and on a signal stopping the program.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+
+#include "AsyncWriter.h"
+
+#include<stdlib.h>
+#include<chrono>
+
+mutex AsyncWriter::writers_lock;
+set<AsyncWriter*> AsyncWriter::writers;
+atomic<int> AsyncWriter::caught(0);
+atomic<int> AsyncWriter::opened(0);
+
+//Used in the signal handler, so they must not take a lock
+static_assert(atomic<int>::is_always_lock_free, "atomic int is not lock-free");
+
+AsyncWriter::AsyncWriter() {
+	interval = WRITER_INTERVAL;
+	requested = served = 0;
+	closing = ok = signaled = false;
+}
+
+AsyncWriter::~AsyncWriter() {
+	close();
+}
+
+/****************************************************
+* Function: open
+* Input Parameter: string, bool, int
+* Output: Open the file and start its thread. The first
+		  file opened sets up flushing at exit and on
+		  signals.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool AsyncWriter::open(string filename, bool append, int seconds) {
+
+	close();
+
+	if (append) os.open(filename.c_str(), ios::app);
+	else os.open(filename.c_str());
+	if (!os.is_open()) return false;
+
+	interval = seconds;
+	current = "";
+	requested = served = 0;
+	closing = signaled = false;
+	ok = true;
+	worker = thread(&AsyncWriter::loop, this);
+
+	lock_guard<mutex> lk(writers_lock);
+	static bool installed = false;
+	if (!installed) {
+		installed = true;
+		atexit(flushAll);
+		signal(SIGINT, handleSignal);
+		signal(SIGTERM, handleSignal);
+		signal(SIGHUP, handleSignal);
+	}
+	writers.insert(this);
+	opened = writers.size();
+
+	return true;
+}
+
+bool AsyncWriter::close() {
+
+	if (!worker.joinable()) return true;
+
+	{
+		lock_guard<mutex> lk(writers_lock);
+		writers.erase(this);
+		opened = writers.size();
+	}
+	{
+		lock_guard<mutex> lk(lock);
+		closing = true;
+		wake.notify_all();
+	}
+	worker.join();
+	os.close();
+
+	return ok && !os.fail();
+}
+
+bool AsyncWriter::is_open() {
+	return worker.joinable();
+}
+
+void AsyncWriter::write(const string &str) {
+	write(str.data(), str.length());
+}
+
+/* Keep the content, waiting for the thread if it falls far behind, but
+   not in the thread itself, which writes the content handed over on a signal */
+void AsyncWriter::write(const char *data, size_t n) {
+
+	unique_lock<mutex> lk(lock);
+	while (current.length() >= WRITER_MAX_BUFFER && ok && this_thread::get_id() != worker.get_id()) written.wait(lk);
+	current.append(data, n);
+	if (current.length() >= WRITER_BUFFER_SIZE || interval == 0) wake.notify_all();
+}
+
+void AsyncWriter::setHandover(function<bool()> f) {
+	lock_guard<mutex> lk(lock);
+	handover = f;
+}
+
+bool AsyncWriter::flush() {
+
+	if (!worker.joinable()) return false;
+
+	unique_lock<mutex> lk(lock);
+	unsigned long request = ++requested;
+	wake.notify_all();
+	while (served < request) written.wait(lk);
+
+	return ok;
+}
+
+/****************************************************
+* Function: loop
+* Input Parameter: void
+* Output: Write the content handed over when a buffer is
+		  full, after the interval, on 'flush' or 'close',
+		  or when a signal is caught, after the owner hands
+		  over its content. The buffers swapped keep their
+		  memory for the next content.
+* Return Value: void
+*****************************************************/
+void AsyncWriter::loop() {
+
+	string data;
+	chrono::steady_clock::time_point last = chrono::steady_clock::now();
+
+	unique_lock<mutex> lk(lock);
+	while (true) {
+		bool stop = (caught != 0 && !signaled), retry = false;
+		bool due = closing || stop || requested > served || current.length() >= WRITER_BUFFER_SIZE ||
+			(current.length() > 0 && chrono::steady_clock::now() - last >= chrono::seconds(interval));
+		if (!due) {
+			wake.wait_for(lk, chrono::milliseconds(WRITER_POLL));
+			continue;
+		}
+
+		//The owner may be waiting for a flush, served before asking again
+		if (stop && handover) {
+			function<bool()> f = handover;
+			lk.unlock();
+			bool handed = f();
+			lk.lock();
+			if (!handed) {
+				stop = false;
+				retry = true;
+			}
+		}
+
+		unsigned long request = requested;
+		data.swap(current);
+		lk.unlock();
+
+		if (data.length() > 0) {
+			os.write(data.data(), data.length());
+			os.flush();
+			data.clear();
+		}
+		last = chrono::steady_clock::now();
+
+		lk.lock();
+		if (!os) ok = false;
+		served = request;
+		written.notify_all();
+
+		if (stop) {
+			signaled = true;
+			lk.unlock();
+			stopBySignal();
+			lk.lock();
+		}
+		if (closing && current.length() == 0) break;
+		if (retry) wake.wait_for(lk, chrono::milliseconds(WRITER_POLL));
+	}
+}
+
+/* The last file written after a signal stops the program by the signal */
+void AsyncWriter::stopBySignal() {
+
+	lock_guard<mutex> lk(writers_lock);
+	set<AsyncWriter*>::iterator it;
+	for (it = writers.begin(); it != writers.end(); it++) {
+		lock_guard<mutex> wlk((*it)->lock);
+		if (!(*it)->signaled) return;
+	}
+	signal(caught, SIG_DFL);
+	raise(caught);
+}
+
+/* Only note the signal, the threads write the files. Without
+   any file open, the program stops at once */
+void AsyncWriter::handleSignal(int sig) {
+
+	caught = sig;
+	if (opened == 0) {
+		signal(sig, SIG_DFL);
+		raise(sig);
+	}
+}
+
+void AsyncWriter::flushAll() {
+
+	lock_guard<mutex> lk(writers_lock);
+	set<AsyncWriter*>::iterator it;
+	for (it = writers.begin(); it != writers.end(); it++) (*it)->flush();
+}
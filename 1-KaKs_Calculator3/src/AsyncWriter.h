@@ -0,0 +1,92 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: AsyncWriter.h
+* Abstract: Declaration of an output file written by its own
+			thread in large blocks, flushed every few seconds,
+			at exit and on a signal stopping the program.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+#if !defined(ASYNCWRITER_H)
+#define  ASYNCWRITER_H
+
+#include<string>
+#include<iostream>
+#include<fstream>
+#include<set>
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<functional>
+#include<atomic>
+#include<signal.h>
+
+using namespace std;
+
+/* Bytes kept before handing them to the thread, and at most waiting for it */
+#define WRITER_BUFFER_SIZE (1 << 20)
+#define WRITER_MAX_BUFFER (4 * WRITER_BUFFER_SIZE)
+/* Default seconds between writes of a partial buffer */
+#define WRITER_INTERVAL 1
+/* Milliseconds between checks of a signal caught */
+#define WRITER_POLL 100
+
+/* Output written by a thread, so that a pair written costs no system call.
+   The content is written when a buffer is full, when it has waited for the
+   interval, on 'flush', and before the program stops by exit or by SIGINT,
+   SIGTERM or SIGHUP. Writers keeping content of their own, e.g. BGZF blocks,
+   hand it over on a signal by 'setHandover' */
+class AsyncWriter {
+
+public:
+	AsyncWriter();
+	~AsyncWriter();
+
+	/* Create the file, or append to it, writing partial buffers every 'interval' seconds */
+	bool open(string filename, bool append=false, int interval=WRITER_INTERVAL);
+	/* Write all content and close the file */
+	bool close();
+	bool is_open();
+
+	void write(const string &str);
+	void write(const char *data, size_t n);
+	/* Wait until all content is written into the file, e.g. for a checkpoint */
+	bool flush();
+	/* Called by the thread on a signal, before writing, to hand over the content kept
+	   by the owner; false while the owner is using it, to be called again */
+	void setHandover(function<bool()> f);
+
+protected:
+	/* Main loop of the thread */
+	void loop();
+	/* Mark the content written after a signal, stopping the program when all files are */
+	void stopBySignal();
+
+	static void handleSignal(int sig);
+	static void flushAll();
+
+	ofstream os;
+	int interval;
+	/* Content not yet handed to the thread */
+	string current;
+	function<bool()> handover;
+	/* Flushes asked for and done */
+	unsigned long requested, served;
+	bool closing, ok, signaled;
+
+	thread worker;
+	mutex lock;
+	condition_variable wake, written;
+
+	/* Open files, flushed at exit or on a signal */
+	static mutex writers_lock;
+	static set<AsyncWriter*> writers;
+	/* Signal caught, and number of open files as seen by the handler,
+	   shared with the threads without locks */
+	static atomic<int> caught, opened;
+};
+
+#endif
@@ -0,0 +1,405 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: BGZF.cpp
+* Abstract: Definition of writing results as BGZF, blocks
+			compressed in parallel, with an index of the
+			blocks and records for extracting rows.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+
+#include "BGZF.h"
+
+#include<stdio.h>
+#include<string.h>
+#include<algorithm>
+#include<zlib.h>
+
+/* Cost of compressing a block, above any pair so that written blocks are not held up */
+#define BGZF_COST 1e300
+
+BGZFIndex::BGZFIndex() {
+	length = 0;
+}
+
+string BGZFIndex::getIndexName(string filename) {
+	return filename + BGZFINDEX_SUFFIX;
+}
+
+/****************************************************
+* Function: load
+* Input Parameter: string
+* Output: Read a header with the length of the content and
+		  the numbers of blocks and records, then the offsets
+		  of the blocks, then the records with their names.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool BGZFIndex::load(string index_filename) {
+
+	block_offsets.clear();
+	block_starts.clear();
+	record_starts.clear();
+	record_names.clear();
+
+	ifstream is(index_filename.c_str());
+	if (!is) return false;
+
+	string header = "";
+	unsigned long nblocks = 0, nrecords = 0, i;
+	length = 0;
+	is >> header >> length >> nblocks >> nrecords;
+	if (header != BGZFINDEX_HEADER) return false;
+
+	long long a, b;
+	for (i = 0; i < nblocks && is >> a >> b; i++) {
+		block_offsets.push_back(a);
+		block_starts.push_back(b);
+	}
+
+	string name;
+	for (i = 0; i < nrecords && is >> a; i++) {
+		is.get();
+		getline(is, name, '\n');
+		record_starts.push_back(a);
+		record_names.push_back(name);
+	}
+
+	return block_offsets.size() == nblocks && record_starts.size() == nrecords;
+}
+
+/****************************************************
+* Function: save
+* Input Parameter: string
+* Output: Write the index into a temporary file, then
+		  rename it, as it is saved again during a run.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool BGZFIndex::save(string index_filename) {
+
+	string tmp = index_filename + ".tmp";
+	ofstream os(tmp.c_str());
+	if (!os) return false;
+
+	unsigned long i;
+	os << BGZFINDEX_HEADER << "\t" << length << "\t" << block_offsets.size() << "\t" << record_starts.size() << endl;
+	for (i = 0; i < block_offsets.size(); i++) os << block_offsets[i] << "\t" << block_starts[i] << '\n';
+	for (i = 0; i < record_starts.size(); i++) os << record_starts[i] << "\t" << record_names[i] << '\n';
+	os.close();
+
+	return os && rename(tmp.c_str(), index_filename.c_str()) == 0;
+}
+
+void BGZFIndex::truncate(long long file_length) {
+
+	unsigned long n = 0;
+	while (n < block_offsets.size() && block_offsets[n] < file_length) n++;
+	if (n < block_offsets.size()) length = block_starts[n];
+	block_offsets.resize(n);
+	block_starts.resize(n);
+
+	n = 0;
+	while (n < record_starts.size() && record_starts[n] < length) n++;
+	record_starts.resize(n);
+	record_names.resize(n);
+}
+
+unsigned long BGZFIndex::findBlock(long long offset) {
+	unsigned long i = upper_bound(block_starts.begin(), block_starts.end(), offset) - block_starts.begin();
+	return i > 0 ? i - 1 : 0;
+}
+
+/****************************************************
+* Function: readRange
+* Input Parameter: istream, long long, long long, string
+* Output: Get the content from 'start' to 'end', reading
+		  only the blocks holding it.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool BGZFIndex::readRange(istream &is, long long start, long long end, string &content) {
+
+	content = "";
+	if (start >= end) return true;
+	if (block_offsets.size() == 0 || end > length) return false;
+
+	unsigned long i = findBlock(start);
+	is.clear();
+	is.seekg(block_offsets[i]);
+
+	string all = "", block;
+	while (block_starts[i] + (long long)all.length() < end && readBlock(is, block)) all += block;
+	if (block_starts[i] + (long long)all.length() < end) return false;
+
+	content = all.substr(start - block_starts[i], end - start);
+
+	return true;
+}
+
+/****************************************************
+* Function: readBlock
+* Input Parameter: istream, string
+* Output: Read a block by the size in its header and
+		  decompress it, checking its CRC.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool BGZFIndex::readBlock(istream &is, string &content) {
+
+	unsigned char h[12];
+	if (!is.read((char*)h, 12) || h[0] != 0x1f || h[1] != 0x8b || !(h[3] & 4)) return false;
+
+	size_t xlen = h[10] | (h[11] << 8), bsize = 0, x;
+	string extra(xlen, '\0');
+	if (!is.read(&extra[0], xlen)) return false;
+	const unsigned char *e = (const unsigned char*)extra.data();
+	for (x = 0; x + 4 <= xlen; x += 4 + (e[x+2] | (e[x+3] << 8))) {
+		if (e[x] == 'B' && e[x+1] == 'C' && x + 6 <= xlen) bsize = (e[x+4] | (e[x+5] << 8)) + 1;
+	}
+	if (bsize < 12 + xlen + 8) return false;
+
+	string data(bsize - 12 - xlen, '\0');
+	if (!is.read(&data[0], data.length())) return false;
+	const unsigned char *t = (const unsigned char*)data.data() + data.length() - 8;
+	unsigned long crc = t[0] | (t[1] << 8) | (t[2] << 16) | ((unsigned long)t[3] << 24);
+	size_t size = t[4] | (t[5] << 8) | (t[6] << 16) | ((size_t)t[7] << 24);
+
+	content.assign(size, '\0');
+	char empty;
+	z_stream zs;
+	memset(&zs, 0, sizeof(zs));
+	if (inflateInit2(&zs, -15) != Z_OK) return false;
+	zs.next_in = (Bytef*)data.data();
+	zs.avail_in = data.length() - 8;
+	zs.next_out = (Bytef*)(size > 0 ? &content[0] : &empty);
+	zs.avail_out = size;
+	bool ok = (inflate(&zs, Z_FINISH) == Z_STREAM_END && zs.total_out == size);
+	inflateEnd(&zs);
+
+	return ok && crc32(0L, (const Bytef*)content.data(), size) == crc;
+}
+
+
+BGZFWriter::BGZFWriter() {
+	length = 0;
+	ok = false;
+}
+
+BGZFWriter::~BGZFWriter() {
+	close();
+}
+
+/****************************************************
+* Function: open
+* Input Parameter: string, bool
+* Output: Create the file, or go on appending to a file
+		  cut at a checkpoint, keeping the part of its
+		  index within the file.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool BGZFWriter::open(string name, bool append) {
+
+	close();
+
+	lock_guard<mutex> lk(writing);
+	filename = name;
+	index = BGZFIndex();
+	current = "";
+	length = 0;
+
+	if (append) {
+		ifstream is(filename.c_str(), ios::binary|ios::ate);
+		length = is ? (long long)is.tellg() : 0;
+		is.close();
+		if (length > 0 && !index.load(BGZFIndex::getIndexName(filename))) {
+			cout << "Error in reading index file..." << endl;
+			return false;
+		}
+		index.truncate(length);
+	}
+
+	group.reset(new TaskGroup());
+	ok = os.open(filename, append);
+	if (ok) os.setHandover([this]() { return handOver(); });
+
+	return ok;
+}
+
+bool BGZFWriter::is_open() {
+	return os.is_open();
+}
+
+/****************************************************
+* Function: close
+* Input Parameter: void
+* Output: Write the blocks left and an empty block, which
+		  marks the end of BGZF file, and save the index.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool BGZFWriter::close() {
+
+	if (!os.is_open()) return true;
+
+	bool flag = flush();
+
+	lock_guard<mutex> lk(writing);
+	string eof;
+	deflateBlock("", eof);
+	os.write(eof.data(), eof.length());
+	if (!os.close()) flag = false;
+
+	group.reset();
+
+	return flag;
+}
+
+void BGZFWriter::write(const string &str) {
+
+	lock_guard<mutex> lk(writing);
+	size_t pos = 0, n;
+	while (pos < str.length()) {
+		n = min(str.length() - pos, (size_t)BGZF_DATA_SIZE - current.length());
+		current.append(str, pos, n);
+		pos += n;
+		if (current.length() == BGZF_DATA_SIZE) submit();
+	}
+}
+
+void BGZFWriter::addRecord(const string &name) {
+	lock_guard<mutex> lk(writing);
+	index.record_starts.push_back(index.length + current.length());
+	index.record_names.push_back(name);
+}
+
+bool BGZFWriter::flush() {
+
+	if (!os.is_open()) return false;
+
+	lock_guard<mutex> lk(writing);
+	submit();
+	drain(0);
+	if (!os.flush()) ok = false;
+
+	return ok && index.save(BGZFIndex::getIndexName(filename));
+}
+
+/* The blocks are handed to the file, written by its thread after this */
+bool BGZFWriter::handOver() {
+
+	unique_lock<mutex> lk(writing, try_to_lock);
+	if (!lk.owns_lock()) return false;
+
+	submit();
+	drain(0);
+	index.save(BGZFIndex::getIndexName(filename));
+
+	return true;
+}
+
+long long BGZFWriter::getLength() {
+	return length;
+}
+
+void BGZFWriter::submit() {
+
+	if (current.length() == 0) return;
+
+	shared_ptr<Block> b(new Block());
+	b->data.swap(current);
+	index.block_starts.push_back(index.length);
+	index.length += b->data.length();
+
+	blocks.push_back(b);
+	group->run([this, b]() {
+		compress(b);
+	}, BGZF_COST);
+
+	//Keep a few blocks per thread in memory
+	drain(4 * TaskGroup::getThreads());
+}
+
+/****************************************************
+* Function: drain
+* Input Parameter: size_t
+* Output: Write the compressed blocks at the front, then
+		  wait for more until at most 'keep' are left,
+		  compressing a block not yet taken at once.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool BGZFWriter::drain(size_t keep) {
+
+	while (!blocks.empty()) {
+		shared_ptr<Block> b = blocks.front();
+		if (blocks.size() > keep) {
+			compress(b);
+			unique_lock<mutex> lk(lock);
+			while (b->state != 2) compressed.wait(lk);
+		}
+		else {
+			lock_guard<mutex> lk(lock);
+			if (b->state != 2) break;
+		}
+
+		index.block_offsets.push_back(length);
+		os.write(b->packed.data(), b->packed.length());
+		length += b->packed.length();
+		blocks.pop_front();
+	}
+
+	return ok;
+}
+
+void BGZFWriter::compress(shared_ptr<Block> b) {
+
+	{
+		lock_guard<mutex> lk(lock);
+		if (b->state != 0) return;
+		b->state = 1;
+	}
+
+	deflateBlock(b->data, b->packed);
+
+	lock_guard<mutex> lk(lock);
+	b->state = 2;
+	compressed.notify_all();
+}
+
+/****************************************************
+* Function: deflateBlock
+* Input Parameter: string, string
+* Output: Compress the data into a BGZF block: a gzip
+		  header with the size of the block in its extra
+		  field 'BC', the deflated data, CRC and length.
+* Return Value: void
+*****************************************************/
+void BGZFWriter::deflateBlock(const string &data, string &packed) {
+
+	unsigned char header[18] = {0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0, 0, 0};
+	string deflated(compressBound(data.length()) + 16, '\0');
+
+	z_stream zs;
+	memset(&zs, 0, sizeof(zs));
+	deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+	zs.next_in = (Bytef*)data.data();
+	zs.avail_in = data.length();
+	zs.next_out = (Bytef*)&deflated[0];
+	zs.avail_out = deflated.length();
+	deflate(&zs, Z_FINISH);
+	deflated.resize(zs.total_out);
+	deflateEnd(&zs);
+
+	unsigned long crc = crc32(0L, (const Bytef*)data.data(), data.length());
+	size_t bsize = 18 + deflated.length() + 8 - 1;
+	header[16] = bsize & 0xff;
+	header[17] = (bsize >> 8) & 0xff;
+
+	unsigned char trailer[8];
+	for (int i = 0; i < 4; i++) {
+		trailer[i] = (crc >> (8 * i)) & 0xff;
+		trailer[4+i] = (data.length() >> (8 * i)) & 0xff;
+	}
+
+	packed.assign((const char*)header, 18);
+	packed += deflated;
+	packed.append((const char*)trailer, 8);
+}
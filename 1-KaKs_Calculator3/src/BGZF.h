@@ -0,0 +1,132 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: BGZF.h
+* Abstract: Declaration of writing results as BGZF, blocks
+			compressed in parallel, with an index of the
+			blocks and records for extracting rows.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+#if !defined(BGZF_H)
+#define  BGZF_H
+
+#include<string>
+#include<iostream>
+#include<fstream>
+#include<vector>
+#include<deque>
+#include<mutex>
+#include<condition_variable>
+#include<memory>
+
+#include "Parallel.h"
+#include "AsyncWriter.h"
+
+using namespace std;
+
+#define BGZFINDEX_SUFFIX ".bgzi"
+#define BGZFINDEX_HEADER "#BGZFIndex"
+
+/* Content of a BGZF block, so that the compressed one fits in 64KB */
+#define BGZF_DATA_SIZE 0xff00
+
+/* Offsets of the blocks of BGZF file and of the records in its content */
+class BGZFIndex {
+
+public:
+	BGZFIndex();
+
+	/* Read and write the index, as "<file>.bgzi" beside BGZF file */
+	bool load(string index_filename);
+	bool save(string index_filename);
+
+	/* Keep the blocks within the first 'length' bytes of the file and the records in them */
+	void truncate(long long length);
+
+	/* Get the block holding an offset of the content */
+	unsigned long findBlock(long long offset);
+	/* Get the content from 'start' to 'end', e.g. of some records */
+	bool readRange(istream &is, long long start, long long end, string &content);
+
+	/* Read one block at the current position, false at the end of file */
+	static bool readBlock(istream &is, string &content);
+	/* Name of index file saved along BGZF file */
+	static string getIndexName(string filename);
+
+public:
+	/* Length of the content */
+	long long length;
+	/* Offsets of each block in the file and in the content */
+	vector<long long> block_offsets, block_starts;
+	/* Offset of each record in the content and its name */
+	vector<long long> record_starts;
+	vector<string> record_names;
+};
+
+/* Output in BGZF. Full blocks are compressed by the threads of the pool and
+   written in order, so that writing does not wait for compressing. The file
+   is written by AsyncWriter, handing over a partial block on a signal */
+class BGZFWriter {
+
+public:
+	BGZFWriter();
+	~BGZFWriter();
+
+	/* Create the file, or append to it as cut at a checkpoint */
+	bool open(string filename, bool append=false);
+	/* Write the last blocks, an empty block marking the end, and the index */
+	bool close();
+	bool is_open();
+
+	void write(const string &str);
+	/* Mark a record starting at the current position, e.g. the rows of a pair */
+	void addRecord(const string &name);
+
+	/* Write all blocks including a partial one, and save the index */
+	bool flush();
+	/* Bytes written into the file */
+	long long getLength();
+
+protected:
+	/* A block to compress, shared with the task compressing it */
+	struct Block {
+		Block(): state(0) {}
+
+		string data, packed;
+		/* 0 for queued, 1 for taken, 2 for compressed */
+		int state;
+	};
+
+	/* Queue the current block for the pool */
+	void submit();
+	/* Write the compressed blocks at the front, waiting until at most 'keep' are left */
+	bool drain(size_t keep);
+	/* Compress a block if not yet taken */
+	void compress(shared_ptr<Block> b);
+	/* Write all blocks and the index on a signal, false if the writer is in use */
+	bool handOver();
+
+	static void deflateBlock(const string &data, string &packed);
+
+	string filename;
+	AsyncWriter os;
+	/* Held by the public functions, so that a signal finds the blocks as they are */
+	mutex writing;
+	long long length;
+	BGZFIndex index;
+
+	/* Content not yet in a block */
+	string current;
+	/* Blocks being compressed, in order */
+	deque< shared_ptr<Block> > blocks;
+
+	mutex lock;
+	condition_variable compressed;
+	unique_ptr<TaskGroup> group;
+	bool ok;
+};
+
+#endif
@@ -0,0 +1,121 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: Checkpoint.cpp
+* Abstract: Definition of checkpoints recording the progress
+			of a run, for resuming it after an interruption.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+
+#include "Checkpoint.h"
+#include<stdio.h>
+#include<stdlib.h>
+#include<unistd.h>
+
+Checkpoint::Checkpoint() {
+	saved = time(NULL);
+}
+
+/****************************************************
+* Function: load
+* Input Parameter: string
+* Output: Read the items of a checkpoint file.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool Checkpoint::load(string filename) {
+
+	items.clear();
+
+	ifstream is(filename.c_str());
+	if (!is) return false;
+
+	string temp = "";
+	getline(is, temp, '\n');
+	if (temp != CHECKPOINT_HEADER) return false;
+
+	while (getline(is, temp, '\n')) {
+		size_t pos = temp.find('\t');
+		if (pos == string::npos) return false;
+		items[temp.substr(0, pos)] = temp.substr(pos + 1);
+	}
+
+	return true;
+}
+
+/****************************************************
+* Function: save
+* Input Parameter: string
+* Output: Write the items, so that an interrupted saving
+		  leaves the last checkpoint as it was.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool Checkpoint::save(string filename) {
+
+	bool flag = true;
+
+	try {
+		string tmp = filename + ".tmp";
+		ofstream os(tmp.c_str());
+		if (!os) throw 1;
+
+		os << CHECKPOINT_HEADER << endl;
+		for (map<string, string>::iterator it = items.begin(); it != items.end(); it++) {
+			os << it->first << "\t" << it->second << endl;
+		}
+		os.close();
+		if (!os || rename(tmp.c_str(), filename.c_str()) != 0) throw 1;
+
+		saved = time(NULL);
+	}
+	catch (...) {
+		cout << "Error in writing checkpoint..." << endl;
+		flag = false;
+	}
+
+	return flag;
+}
+
+void Checkpoint::remove(string filename) {
+	::remove(filename.c_str());
+}
+
+void Checkpoint::set(string key, string value) {
+	items[key] = value;
+}
+
+void Checkpoint::set(string key, double value) {
+	//All digits, so that a resumed run goes on with the same values
+	char buf[32];
+	snprintf(buf, sizeof(buf), "%.17g", value);
+	items[key] = buf;
+}
+
+string Checkpoint::get(string key) {
+	map<string, string>::iterator it = items.find(key);
+	return it == items.end() ? "" : it->second;
+}
+
+double Checkpoint::getNumber(string key) {
+	return atof(get(key).c_str());
+}
+
+void Checkpoint::setInteger(string key, long long value) {
+	char buf[32];
+	snprintf(buf, sizeof(buf), "%lld", value);
+	items[key] = buf;
+}
+
+long long Checkpoint::getInteger(string key) {
+	return strtoll(get(key).c_str(), NULL, 10);
+}
+
+bool Checkpoint::isDue(int interval) {
+	return interval >= 0 && time(NULL) - saved >= interval;
+}
+
+bool Checkpoint::truncateFile(string filename, long long length) {
+	return truncate(filename.c_str(), length) == 0;
+}
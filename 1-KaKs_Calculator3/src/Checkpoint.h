@@ -0,0 +1,63 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: Checkpoint.h
+* Abstract: Declaration of checkpoints recording the progress
+			of a run, for resuming it after an interruption.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+#if !defined(CHECKPOINT_H)
+#define  CHECKPOINT_H
+
+#include<string>
+#include<iostream>
+#include<sstream>
+#include<fstream>
+#include<map>
+#include<time.h>
+
+using namespace std;
+
+#define CHECKPOINT_SUFFIX ".ckpt"
+#define CHECKPOINT_HEADER "#Checkpoint"
+
+/* Items of progress saved as "key<TAB>value" lines, replaced at once on saving */
+class Checkpoint {
+
+public:
+	Checkpoint();
+
+	/* Read the checkpoint, false if there is none */
+	bool load(string filename);
+	/* Write the checkpoint into a temporary file, then rename it */
+	bool save(string filename);
+	/* Delete the checkpoint after a finished run */
+	static void remove(string filename);
+
+	/* Set and get items */
+	void set(string key, string value);
+	void set(string key, double value);
+	string get(string key);
+	double getNumber(string key);
+	/* Counts and offsets, exact beyond the digits of double */
+	void setInteger(string key, long long value);
+	long long getInteger(string key);
+
+	/* Whether the interval in seconds passed since the last saving, never if negative */
+	bool isDue(int interval);
+
+	/* Cut a file to its first 'length' bytes, as it was at the checkpoint */
+	static bool truncateFile(string filename, long long length);
+
+public:
+	map<string, string> items;
+
+protected:
+	/* Time of the last saving */
+	time_t saved;
+};
+
+#endif
@@ -0,0 +1,343 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: Cluster.cpp
+* Abstract: Definition of a coordinator dispatching jobs to
+			worker processes over TCP, and of the messages
+			between them.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+
+#include "Cluster.h"
+
+#include<stdlib.h>
+#include<string.h>
+#include<unistd.h>
+#include<netdb.h>
+#include<sys/types.h>
+#include<sys/socket.h>
+#include<netinet/in.h>
+#include<netinet/tcp.h>
+#include<arpa/inet.h>
+
+/* Limit of a field, against a corrupted stream */
+#define MAX_FIELD_LENGTH (1u<<30)
+
+static bool sendAll(int fd, const char *buf, size_t n) {
+
+	while (n > 0) {
+		ssize_t k = send(fd, buf, n, MSG_NOSIGNAL);
+		if (k <= 0) return false;
+		buf += k;
+		n -= k;
+	}
+	return true;
+}
+
+static bool recvAll(int fd, char *buf, size_t n) {
+
+	while (n > 0) {
+		ssize_t k = recv(fd, buf, n, 0);
+		if (k <= 0) return false;
+		buf += k;
+		n -= k;
+	}
+	return true;
+}
+
+static void putLength(string &buf, unsigned int n) {
+	n = htonl(n);
+	buf.append((const char*)&n, 4);
+}
+
+static bool getLength(int fd, unsigned int &n) {
+	if (!recvAll(fd, (char*)&n, 4)) return false;
+	n = ntohl(n);
+	return true;
+}
+
+bool sendMessage(int fd, const vector<string> &fields) {
+
+	string buf = "";
+	putLength(buf, fields.size());
+	for (unsigned int i = 0; i < fields.size(); i++) {
+		putLength(buf, fields[i].length());
+		buf += fields[i];
+	}
+
+	return sendAll(fd, buf.data(), buf.length());
+}
+
+bool recvMessage(int fd, vector<string> &fields) {
+
+	unsigned int n, len, i;
+	fields.clear();
+
+	if (!getLength(fd, n) || n > MAX_FIELD_LENGTH) return false;
+	for (i = 0; i < n; i++) {
+		if (!getLength(fd, len) || len > MAX_FIELD_LENGTH) return false;
+		string field(len, '\0');
+		if (len > 0 && !recvAll(fd, &field[0], len)) return false;
+		fields.push_back(field);
+	}
+
+	return true;
+}
+
+int listenPort(int port) {
+
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) return -1;
+
+	int on = 1;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+
+	if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 64) < 0) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+int connectTo(string address, int retries) {
+
+	size_t pos = address.rfind(':');
+	if (pos == string::npos) return -1;
+	string host = address.substr(0, pos), port = address.substr(pos + 1);
+
+	struct addrinfo hints, *res, *p;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	//The coordinator may be starting
+	for (int i = 0; i <= retries; i++) {
+		if (i > 0) sleep(1);
+		if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0) continue;
+
+		for (p = res; p != NULL; p = p->ai_next) {
+			int fd = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
+			if (fd < 0) continue;
+			if (connect(fd, p->ai_addr, p->ai_addrlen) == 0) {
+				int on = 1;
+				setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+				freeaddrinfo(res);
+				return fd;
+			}
+			close(fd);
+		}
+		freeaddrinfo(res);
+	}
+
+	return -1;
+}
+
+void closeConnection(int fd) {
+	close(fd);
+}
+
+WorkServer::WorkServer(const vector<string> &c) {
+	conf = c;
+	closed = false;
+	listen_fd = -1;
+	max_tries = 3;
+}
+
+WorkServer::~WorkServer() {
+	if (listen_fd >= 0) finish();
+}
+
+/********************************************
+* Function: start
+* Input Parameter: int
+* Output: Listen on the port and accept workers
+		  in the background.
+* Return Value: True if succeed, otherwise false.
+*********************************************/
+bool WorkServer::start(int port) {
+
+	listen_fd = listenPort(port);
+	if (listen_fd < 0) {
+		cout << "Error in listening on port " << port << "..." << endl;
+		return false;
+	}
+
+	acceptor = thread(&WorkServer::acceptLoop, this);
+	cout << "Waiting for workers on port " << port << "..." << endl;
+
+	return true;
+}
+
+void WorkServer::submit(unsigned long id, const vector<string> &request) {
+
+	lock_guard<mutex> lk(lock);
+	jobs[id].request = request;
+	ready.push_back(id);
+	changed.notify_all();
+}
+
+/********************************************
+* Function: finish
+* Input Parameter: void
+* Output: Wait until all jobs are answered, then
+		  stop the workers and the acceptor.
+* Return Value: void
+*********************************************/
+void WorkServer::finish() {
+
+	{
+		unique_lock<mutex> lk(lock);
+		closed = true;
+		changed.notify_all();
+		while (!jobs.empty()) changed.wait(lk);
+	}
+
+	//Wake up the acceptor
+	shutdown(listen_fd, SHUT_RDWR);
+	if (acceptor.joinable()) acceptor.join();
+	close(listen_fd);
+	listen_fd = -1;
+
+	for (int i = 0; i < connections.size(); i++) connections[i].join();
+	connections.clear();
+}
+
+void WorkServer::acceptLoop() {
+
+	while (true) {
+		struct sockaddr_in addr;
+		socklen_t len = sizeof(addr);
+		int fd = accept(listen_fd, (struct sockaddr*)&addr, &len);
+		if (fd < 0) {
+			lock_guard<mutex> lk(lock);
+			if (closed && jobs.empty()) return;
+			continue;
+		}
+
+		int on = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+		string peer = string(inet_ntoa(addr.sin_addr)) + ":" + to_string(ntohs(addr.sin_port));
+
+		lock_guard<mutex> lk(lock);
+		connections.push_back(thread(&WorkServer::serveWorker, this, fd, peer));
+	}
+}
+
+/********************************************
+* Function: serveWorker
+* Input Parameter: int, string
+* Output: Send the configuration, then keep the
+		  worker busy with as many jobs as it asks
+		  for in 'HELLO', passing each 'DONE' to
+		  'onReply'. When the worker is lost, its
+		  jobs are sent to the others.
+* Return Value: void
+*********************************************/
+void WorkServer::serveWorker(int fd, string peer) {
+
+	vector<string> msg;
+	vector<unsigned long> sent;
+	int capacity = 0;
+
+	if (sendMessage(fd, conf) && recvMessage(fd, msg) && msg.size() == 2 && msg[0] == "HELLO") {
+		capacity = atoi(msg[1].c_str());
+		cout << "Worker connected: " << peer << endl;
+	}
+
+	bool lost = (capacity < 1);
+	while (!lost) {
+		//Fill up the worker, waiting for a job only when it is idle
+		unsigned long id;
+		vector<string> request;
+		while (sent.size() < capacity && take(id, request, sent.empty())) {
+			request.insert(request.begin(), to_string(id));
+			request.insert(request.begin(), "PAIR");
+			sent.push_back(id);
+			if (!sendMessage(fd, request)) {
+				lost = true;
+				break;
+			}
+		}
+		if (lost || sent.empty()) break;
+
+		if (!recvMessage(fd, msg) || msg.size() < 2 || msg[0] != "DONE") {
+			lost = true;
+			break;
+		}
+		id = strtoul(msg[1].c_str(), NULL, 10);
+		for (int i = 0; i < sent.size(); i++) {
+			if (sent[i] == id) {
+				sent.erase(sent.begin() + i);
+				break;
+			}
+		}
+
+		msg.erase(msg.begin(), msg.begin() + 2);
+		if (answer(id) && onReply) onReply(id, msg);
+	}
+
+	if (lost) {
+		if (capacity > 0) cout << "Worker lost: " << peer << ", sending its " << sent.size() << " pair(s) again" << endl;
+		requeue(sent);
+	}
+	else {
+		vector<string> stop(1, "STOP");
+		sendMessage(fd, stop);
+	}
+	close(fd);
+}
+
+bool WorkServer::take(unsigned long &id, vector<string> &request, bool block) {
+
+	unique_lock<mutex> lk(lock);
+	while (block && ready.empty() && !(closed && jobs.empty())) changed.wait(lk);
+	if (ready.empty()) return false;
+
+	id = ready.front();
+	ready.pop_front();
+	Job &job = jobs[id];
+	job.tries++;
+	request = job.request;
+
+	return true;
+}
+
+bool WorkServer::answer(unsigned long id) {
+
+	lock_guard<mutex> lk(lock);
+	if (jobs.erase(id) == 0) return false;
+	changed.notify_all();
+
+	return true;
+}
+
+void WorkServer::requeue(const vector<unsigned long> &ids) {
+
+	vector<unsigned long> failed;
+	{
+		lock_guard<mutex> lk(lock);
+		for (int i = ids.size() - 1; i >= 0; i--) {
+			map<unsigned long, Job>::iterator it = jobs.find(ids[i]);
+			if (it == jobs.end()) continue;
+			if (it->second.tries >= max_tries) failed.push_back(ids[i]);
+			else ready.push_front(ids[i]);
+		}
+		changed.notify_all();
+	}
+
+	//A job failing on every try, e.g. crashing the workers
+	for (int i = 0; i < failed.size(); i++) {
+		vector<string> none;
+		if (answer(failed[i]) && onReply) onReply(failed[i], none);
+	}
+}
@@ -0,0 +1,95 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: Cluster.h
+* Abstract: Declaration of a coordinator dispatching jobs to
+			worker processes over TCP, and of the messages
+			between them.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+#if !defined(CLUSTER_H)
+#define  CLUSTER_H
+
+#include<string>
+#include<iostream>
+#include<vector>
+#include<deque>
+#include<map>
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<functional>
+
+using namespace std;
+
+/* A message is a count of fields followed by each field, both
+   preceded by their length as 4 bytes in network order */
+bool sendMessage(int fd, const vector<string> &fields);
+bool recvMessage(int fd, vector<string> &fields);
+
+/* Listen on a TCP port of all interfaces, -1 if failed */
+int listenPort(int port);
+/* Connect to "host:port", retrying for a while, -1 if failed */
+int connectTo(string address, int retries=30);
+/* Close a connection */
+void closeConnection(int fd);
+
+/* Coordinator of workers: each connected worker is sent jobs, as many at
+   a time as it asks for, and jobs of a lost worker are sent to the others */
+class WorkServer {
+
+public:
+	WorkServer(const vector<string> &conf);
+	~WorkServer();
+
+	/* Accept workers on the port */
+	bool start(int port);
+	/* Queue a job of given id, answered by calling 'onReply' */
+	void submit(unsigned long id, const vector<string> &request);
+	/* No more jobs; wait for all jobs answered and stop the workers */
+	void finish();
+
+	/* Called with the reply of a job, empty if the job failed on all tries */
+	function<void(unsigned long, vector<string>&)> onReply;
+	/* Times a job is sent before it fails */
+	int max_tries;
+
+protected:
+	/* Accept workers until finished */
+	void acceptLoop();
+	/* Send jobs to a worker and take its replies */
+	void serveWorker(int fd, string peer);
+	/* Take a job to send, waiting for one if 'block'; false if none */
+	bool take(unsigned long &id, vector<string> &request, bool block);
+	/* Remove a job answered, false if it was answered already */
+	bool answer(unsigned long id);
+	/* Send the jobs of a lost worker again, or fail them */
+	void requeue(const vector<unsigned long> &ids);
+
+	struct Job {
+		Job(): tries(0) {}
+		vector<string> request;
+		int tries;
+	};
+
+	/* Configuration sent to each worker first */
+	vector<string> conf;
+
+	mutex lock;
+	condition_variable changed;
+	/* Jobs not answered yet */
+	map<unsigned long, Job> jobs;
+	/* Jobs waiting for a worker */
+	deque<unsigned long> ready;
+	/* No more jobs are submitted */
+	bool closed;
+
+	int listen_fd;
+	thread acceptor;
+	vector<thread> connections;
+};
+
+#endif
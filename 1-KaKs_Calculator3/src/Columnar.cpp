@@ -0,0 +1,277 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: Columnar.cpp
+* Abstract: Definition of a binary columnar file of results,
+			written without formatting the values and read
+			back into rows of text by KaKsView.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+
+#include "Columnar.h"
+
+/* Bytes to add for aligning a length to 8 bytes */
+static size_t padding(long long length) {
+	return (8 - length % 8) % 8;
+}
+
+/* Write the elements of a vector as they are in memory */
+template<class T>
+static void writeArray(AsyncWriter &os, const vector<T> &v) {
+	if (v.size() > 0) os.write((const char*)&v[0], v.size() * sizeof(T));
+}
+
+template<class T>
+static bool readArray(ifstream &is, vector<T> &v, size_t n) {
+	v.resize(n);
+	return n == 0 || is.read((char*)&v[0], n * sizeof(T));
+}
+
+ColumnWriter::ColumnWriter() {
+	length = 0;
+}
+
+ColumnWriter::~ColumnWriter() {
+	close();
+}
+
+/****************************************************
+* Function: open
+* Input Parameter: string, string, bool
+* Output: Create the file and write its header with the
+		  title, or go on appending chunks to a file cut
+		  at a checkpoint.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool ColumnWriter::open(string filename, const string &title, bool append) {
+
+	close();
+
+	lock_guard<mutex> lk(writing);
+	rows.clear();
+	length = 0;
+
+	if (append) {
+		ifstream is(filename.c_str(), ios::binary|ios::ate);
+		length = is ? (long long)is.tellg() : 0;
+		is.close();
+	}
+	if (!os.open(filename, append)) return false;
+	os.setHandover([this]() { return handOver(); });
+
+	if (length == 0) {
+		uint32_t version = COLUMNAR_VERSION, values = RESULT_VALUES;
+		uint64_t title_length = title.length();
+		os.write(COLUMNAR_MAGIC, 8);
+		os.write((const char*)&version, 4);
+		os.write((const char*)&values, 4);
+		os.write((const char*)&title_length, 8);
+		os.write(title);
+		length = 24 + title.length();
+		os.write(string(padding(length), '\0'));
+		length += padding(length);
+	}
+
+	return true;
+}
+
+bool ColumnWriter::close() {
+
+	if (!os.is_open()) return true;
+
+	bool flag = flush();
+	lock_guard<mutex> lk(writing);
+	if (!os.close()) flag = false;
+
+	return flag;
+}
+
+bool ColumnWriter::is_open() {
+	return os.is_open();
+}
+
+void ColumnWriter::add(const ResultRow &row) {
+
+	lock_guard<mutex> lk(writing);
+	rows.push_back(row);
+	if (rows.size() >= COLUMNAR_ROWS) writeChunk();
+}
+
+long long ColumnWriter::getLength() {
+	return length;
+}
+
+bool ColumnWriter::flush() {
+
+	if (!os.is_open()) return false;
+
+	lock_guard<mutex> lk(writing);
+	writeChunk();
+
+	return os.flush();
+}
+
+bool ColumnWriter::handOver() {
+
+	unique_lock<mutex> lk(writing, try_to_lock);
+	if (!lk.owns_lock()) return false;
+	writeChunk();
+
+	return true;
+}
+
+/****************************************************
+* Function: writeChunk
+* Input Parameter: void
+* Output: Write the rows kept as a chunk: the values one
+		  column after another, and the names and models
+		  as ids into a table of the distinct strings.
+* Return Value: void
+*****************************************************/
+void ColumnWriter::writeChunk() {
+
+	if (rows.size() == 0) return;
+
+	uint32_t n = rows.size(), i, k;
+	vector<double> values((size_t)RESULT_VALUES * n);
+	vector<uint64_t> lengths(n);
+	vector<uint32_t> names(n), methods(n), models(n), ends;
+	map<string, uint32_t> ids;
+	string text = "";
+
+	//Id of a string in the table, added if new
+	auto getId = [&](const string &str) -> uint32_t {
+		map<string, uint32_t>::iterator it = ids.find(str);
+		if (it != ids.end()) return it->second;
+		text += str;
+		ends.push_back(text.length());
+		return ids[str] = ends.size() - 1;
+	};
+
+	double v[RESULT_VALUES];
+	for (i = 0; i < n; i++) {
+		Base::getValues(rows[i], v);
+		for (k = 0; k < RESULT_VALUES; k++) values[(size_t)k * n + i] = v[k];
+		lengths[i] = rows[i].length;
+		names[i] = getId(rows[i].seq_name);
+		methods[i] = getId(rows[i].method);
+		models[i] = getId(rows[i].model);
+	}
+
+	//The chunk ends at 8 bytes
+	uint32_t strings = ends.size();
+	text.append(padding(4 * (3 * n + strings) + text.length()), '\0');
+	uint32_t text_length = text.length();
+
+	os.write(COLUMNAR_CHUNK, 4);
+	os.write((const char*)&n, 4);
+	os.write((const char*)&strings, 4);
+	os.write((const char*)&text_length, 4);
+	writeArray(os, values);
+	writeArray(os, lengths);
+	writeArray(os, names);
+	writeArray(os, methods);
+	writeArray(os, models);
+	writeArray(os, ends);
+	os.write(text);
+
+	length += 16 + 8 * (RESULT_VALUES + 1) * (long long)n + 4 * (3 * (long long)n + strings) + text_length;
+	rows.clear();
+}
+
+
+/****************************************************
+* Function: open
+* Input Parameter: string
+* Output: Check the header and read the title.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool ColumnReader::open(string filename) {
+
+	failed = false;
+	is.open(filename.c_str(), ios::binary);
+	if (!is) return false;
+
+	char magic[8];
+	uint32_t version, values;
+	uint64_t title_length;
+	if (!is.read(magic, 8) || string(magic, 8) != COLUMNAR_MAGIC) return false;
+	if (!is.read((char*)&version, 4) || !is.read((char*)&values, 4) || !is.read((char*)&title_length, 8)) return false;
+	if (version != COLUMNAR_VERSION || values != RESULT_VALUES) return false;
+
+	title.assign(title_length, '\0');
+	if (title_length > 0 && !is.read(&title[0], title_length)) return false;
+	is.ignore(padding(24 + title_length));
+
+	return !is.fail();
+}
+
+/****************************************************
+* Function: next
+* Input Parameter: vector
+* Output: Read a chunk into rows.
+* Return Value: False at the end of file or on an error.
+*****************************************************/
+bool ColumnReader::next(vector<ResultRow> &rows) {
+
+	rows.clear();
+
+	char magic[4];
+	uint32_t n, strings, text_length, i, k;
+	is.read(magic, 4);
+	if (is.gcount() == 0) return false;
+
+	vector<double> values;
+	vector<uint64_t> lengths;
+	vector<uint32_t> names, methods, models, ends;
+	string text;
+
+	if (is.gcount() != 4 || string(magic, 4) != COLUMNAR_CHUNK || !is.read((char*)&n, 4) ||
+		!is.read((char*)&strings, 4) || !is.read((char*)&text_length, 4) ||
+		!readArray(is, values, (size_t)RESULT_VALUES * n) || !readArray(is, lengths, n) ||
+		!readArray(is, names, n) || !readArray(is, methods, n) || !readArray(is, models, n) ||
+		!readArray(is, ends, strings)) {
+		failed = true;
+		return false;
+	}
+	text.assign(text_length, '\0');
+	if (text_length > 0 && !is.read(&text[0], text_length)) {
+		failed = true;
+		return false;
+	}
+
+	//Strings of the table by their ends
+	vector<string> table(strings);
+	for (i = 0; i < strings; i++) {
+		uint32_t start = i > 0 ? ends[i - 1] : 0;
+		if (ends[i] < start || ends[i] > text_length) {
+			failed = true;
+			return false;
+		}
+		table[i] = text.substr(start, ends[i] - start);
+	}
+
+	rows.resize(n);
+	double v[RESULT_VALUES];
+	for (i = 0; i < n; i++) {
+		if (names[i] >= strings || methods[i] >= strings || models[i] >= strings) {
+			failed = true;
+			return false;
+		}
+		for (k = 0; k < RESULT_VALUES; k++) v[k] = values[(size_t)k * n + i];
+		Base::setValues(rows[i], v);
+		rows[i].length = lengths[i];
+		rows[i].seq_name = table[names[i]];
+		rows[i].method = table[methods[i]];
+		rows[i].model = table[models[i]];
+	}
+
+	return true;
+}
+
+bool ColumnReader::isFailed() {
+	return failed;
+}
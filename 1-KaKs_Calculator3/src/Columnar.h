@@ -0,0 +1,96 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: Columnar.h
+* Abstract: Declaration of a binary columnar file of results,
+			written without formatting the values and read
+			back into rows of text by KaKsView.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+#if !defined(COLUMNAR_H)
+#define  COLUMNAR_H
+
+#include<string>
+#include<iostream>
+#include<fstream>
+#include<vector>
+#include<map>
+#include<stdint.h>
+
+#include "base.h"
+#include "AsyncWriter.h"
+
+using namespace std;
+
+#define COLUMNAR_MAGIC "KAKSCOL1"
+#define COLUMNAR_CHUNK "ROWS"
+#define COLUMNAR_VERSION 1
+/* Rows in a chunk */
+#define COLUMNAR_ROWS 4096
+
+/*	Layout, in the byte order of the machine and aligned to 8 bytes:
+	Header:	char magic[8]="KAKSCOL1", uint32 version, uint32 values=RESULT_VALUES,
+			uint64 title_length, char title[], padded to 8 bytes
+	Chunks:	char magic[4]="ROWS", uint32 rows, uint32 strings, uint32 text_length,
+			double values[RESULT_VALUES][rows], one column after another in the order
+			of 'Base::getValues', uint64 length[rows],
+			uint32 name[rows], method[rows], model[rows] as ids of strings,
+			uint32 string_end[strings], char text[text_length], padded to 8 bytes
+	Values not available are kept as they are, so that the rows are formatted as in text */
+
+/* Writer of the binary columnar file, a chunk of columns per COLUMNAR_ROWS rows.
+   The file is written by AsyncWriter, handing over the rows kept on a signal */
+class ColumnWriter {
+
+public:
+	ColumnWriter();
+	~ColumnWriter();
+
+	/* Create the file with the title of the columns, or append to it as cut at a checkpoint */
+	bool open(string filename, const string &title, bool append=false);
+	/* Write the rows left */
+	bool close();
+	bool is_open();
+
+	void add(const ResultRow &row);
+	/* Write the rows kept as a chunk, and wait until they are in the file */
+	bool flush();
+	/* Bytes written into the file */
+	long long getLength();
+
+protected:
+	/* Write the rows kept as a chunk into the file */
+	void writeChunk();
+	/* Write the rows kept on a signal, false if the writer is in use */
+	bool handOver();
+
+	AsyncWriter os;
+	long long length;
+	vector<ResultRow> rows;
+	/* Held by the public functions, so that a signal finds the rows as they are */
+	mutex writing;
+};
+
+/* Reader of the binary columnar file, a chunk at a time */
+class ColumnReader {
+
+public:
+	/* Open the file and read its title */
+	bool open(string filename);
+	/* Get the rows of the next chunk, false at the end of file */
+	bool next(vector<ResultRow> &rows);
+	/* Whether the file ended in the middle of a chunk */
+	bool isFailed();
+
+public:
+	string title;
+
+protected:
+	ifstream is;
+	bool failed;
+};
+
+#endif
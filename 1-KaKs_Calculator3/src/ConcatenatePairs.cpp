@@ -18,6 +18,8 @@
 #include<iostream>
 #include<fstream>
 
+#include "AXTReader.h"
+
 using namespace std;
 
 string result;	//Result for outputing into a file
@@ -29,33 +31,28 @@ bool readFile(const char *filename) {
 	seq1 = seq2 ="";
 
 	try	{
-		ifstream is(filename);
-		if (!is) {
+		AXTReader axt;
+		if (!axt.open(filename)) {
 			cout<<"\nError in opening file..."<<endl;
 			throw 1;
 		}
 		
 		cout<<"\nPlease wait while reading sequences and concatenating..."<<endl;
 
-		string temp="", name="", str="";
+		string str="";
+		AXTRecord rec;
 		
-		while (getline(is, temp, '\n'))	{
-			
-			name = temp;
+		while (axt.next(rec))	{
 			
-			getline(is, temp, '\n');
-			while (temp!="") {				
-				str += temp;
-				getline(is, temp, '\n');				
-			}
+			rec.join(str);
 
 			seq1 += str.substr(0, str.length()/2);
 			seq2 += str.substr(str.length()/2, str.length()/2);
-			name = str = "";			
+			str = "";			
 		}
 		
-		is.close();
-		is.clear();	
+		if (axt.isFailed()) throw 1;
+		axt.close();
 		
 		result += "Concatenate-";	result += filename;	result += '\n';	
 		result += seq1;		result += '\n';
@@ -97,6 +94,9 @@ int main(int argc, char* argv[]) {
 		return 0;
 	}
 
+	//Decompress the blocks of BGZF input on all cores
+	TaskGroup::setThreads(thread::hardware_concurrency());
+
 	try {
 		if (!readFile(argv[1])) throw 1;
 		if (!writeFile(argv[2], result.c_str())) throw 1;
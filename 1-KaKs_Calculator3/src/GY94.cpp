@@ -104,7 +104,10 @@ SYM, GTR: 	rTC!=rAG!=rTA!=rCG!=rTG!=rCA
 GY94::GY94() {
 }
 
-GY94::GY94(string NulModel) {
+GY94::GY94(const Context &c): Base(c) {
+}
+
+GY94::GY94(const Context &c, string NulModel): Base(c) {
 
 	name = "GY-"+NulModel;
 	Iround=0;
@@ -114,7 +117,7 @@ GY94::GY94(string NulModel) {
 	com.ns = 2; 
 	lnL = 0.0;
 	
-	com.icode = genetic_code-1;
+	com.icode = ctx.genetic_code-1;
 	if (com.icode>11) com.icode = 0;
 	Nsensecodon = getNumNonsense(com.icode);
 	com.ncode = 64 - Nsensecodon;
@@ -145,6 +148,30 @@ double GY94::rndu(void) {
 	return ldexp((double)w_rndu, -32);
 }
 
+/********************************************
+* Function: skipRuns
+* Input Parameter: unsigned long
+* Output: Jump the random numbers over the ones
+		  used by 'runs' fits, each drawing 2+nkappa
+		  initial values in PairwiseCodon.
+* Return Value: void
+*********************************************/
+void GY94::skipRuns(unsigned long runs) {
+
+	unsigned long m = runs*(2+com.nkappa);
+	//w = a*w+c, squared by (a,c) -> (a*a, (a+1)*c)
+	unsigned int a=69069, c=1, A=1, C=0;
+	for (; m>0; m>>=1) {
+		if (m&1) {
+			A = A*a;
+			C = C*a+c;
+		}
+		c = (a+1)*c;
+		a = a*a;
+	}
+	w_rndu = A*w_rndu+C;
+}
+
 
 /* x[i]=x0[i] + t*p[i] */
 double GY94::fun_ls (double t, double x0[], double p[], double x[], int n) {
@@ -341,24 +368,42 @@ int GY94::GetCodonFreqs(double pi[]) {
 int GY94::gradientB(int n, double x[], double f0, double g[], double space[], int xmark[]) {
 /* f0=fun(x) is always provided.
    xmark=0: central; 1: upper; -1: down
+   The points x1 (xs[2i]) and x0 (xs[2i+1]) of all parameters are independent,
+   so their likelihoods are evaluated in parallel, each in the workspace of
+   its thread. ming2 evaluates x again at the end, so kappa and omega kept in
+   the object are not affected.
 */
-   int i,j;
-   double *x0=space, *x1=space+n, eh0=Small_Diff, eh;  /* eh0=1e-6 || 1e-7 */
+   int i,j, central[10];
+   double eh0=Small_Diff, eh[10];  /* eh0=1e-6 || 1e-7 */
+   double xs[20][10], f[20];
 
    for(i=0; i<n; i++) {
-      eh=eh0*(fabs(x[i])+1);
-      if (xmark[i]==0 && SIZEp<1) {    //central 
-         for (j=0; j<n; j++)  x0[j]=x1[j]=x[j];
-         eh=pow(eh,.67);  x0[i]-=eh; x1[i]+=eh;
-         g[i]=(lfun2dSdN(x1,n)-(lfun2dSdN)(x0,n))/(eh*2.0);
+      eh[i]=eh0*(fabs(x[i])+1);
+      for (j=0; j<n; j++)  xs[2*i][j]=xs[2*i+1][j]=x[j];
+      central[i]=(xmark[i]==0 && SIZEp<1);
+      if (central[i]) {    //central 
+         eh[i]=pow(eh[i],.67);  xs[2*i+1][i]-=eh[i]; xs[2*i][i]+=eh[i];
       }
       else  {//forward or backward
-         for(j=0; j<n; j++)  x1[j]=x[j];
-         if (xmark[i]) eh*=-xmark[i];
-         x1[i] += eh;
-         g[i]=(lfun2dSdN(x1,n)-f0)/eh;
+         if (xmark[i]) eh[i]*=-xmark[i];
+         xs[2*i][i] += eh[i];
       }
    }
+
+   TaskGroup group;
+   for(i=0; i<2*n; i++) {
+      if (i%2==1 && !central[i/2]) continue;
+      group.run([this, n, i, &xs, &f]() {
+         static thread_local LikWork w;
+         f[i]=lfun2dSdN(xs[i], n, w.KAPPA, w.Root, w.U, w.V, w.PMat);
+      });
+   }
+   group.wait();
+
+   for(i=0; i<n; i++) {
+      if (central[i]) g[i]=(f[2*i]-f[2*i+1])/(eh[i]*2.0);
+      else g[i]=(f[2*i]-f0)/eh[i];
+   }
    return(0);
 }
 
@@ -1016,6 +1061,14 @@ int GY94::parseSubRates(string model, double kappa[]) {
 	return 1;
 }
 
+/* Equal codon frequency, set before EigenQc for the models assuming it */
+void GY94::setEqualFreqs() {
+	if(model=="JC" || model=="K2P" || model=="TNEF" || model=="K3P"||
+		model=="TIMEF" ||model=="TVMEF"|| model=="SYM") {
+		initArray(com.pi, 64, 1.0/(64-getNumNonsense(ctx.genetic_code)));
+	}
+}
+
 /* Construct Q: transition probability matrix 64*64 */
 int GY94::EigenQc (int getstats, double blength, double *S, double *dS, double *dN, double Root[], double U[], double V[], double kappa[], double omega, double Q[]) {
 /* This contructs the rate matrix Q for codon substitution and get the eigen
@@ -1050,12 +1103,6 @@ int GY94::EigenQc (int getstats, double blength, double *S, double *dS, double *
 	for(i=0; i<3; d[i]=d0[i]=ts[i]=tv[i]=0, i++);
 	initArray(Q, n*n);
 
-	//Equal codon frequency
-	if(model=="JC" || model=="K2P" || model=="TNEF" || model=="K3P"||
-		model=="TIMEF" ||model=="TVMEF"|| model=="SYM") {
-		initArray(com.pi, 64, 1.0/(64-getNumNonsense(genetic_code)));
-	}
-
 	//Parse substitution rates according to the given model
 	parseSubRates(model, kappa);
 	
@@ -1152,20 +1199,24 @@ double GY94::lfun2dSdN(double x[], int np) {
    Data are clean and coded.
    Transition probability pijt is calculated for observed patterns only.
 */
+	com.kappa=x[1]; 
+	com.omega=x[1+com.nkappa];
+
+	return lfun2dSdN(x, np, com.KAPPA, Root, U, V, PMat);
+}
+
+double GY94::lfun2dSdN(double x[], int np, double pkappa[], double Root[], double U[], double V[], double PMat[]) {
+
 	int n=com.ncode, h,k, ik, z0,z1;
 	double  fh,expt[CODON], lnL1=0;
-	double *pkappa=com.KAPPA;
 
 	//cout<<name.c_str()<<": "<<com.ncode<<"\t"<<Nsensecodon<<endl;
 	
 	k=1, ik=0;
-	com.kappa=x[k]; 
 	for (ik=0; ik<com.nkappa; ik++) 
 		pkappa[ik]=x[k++];
 
-	com.omega=x[1+com.nkappa];
-
-	EigenQc(0,-1,NULL,NULL,NULL, Root, U, V, pkappa, com.omega, PMat);
+	EigenQc(0,-1,NULL,NULL,NULL, Root, U, V, pkappa, x[1+com.nkappa], PMat);
 	
 	//t = x[0],  exp(Qt)
 	for(k=0; k<n; k++) {
@@ -1216,7 +1267,7 @@ int GY94::PairwiseCodon(double space[]) {
 	copyArray(com.fpatt, fpatt0, npatt0);
 	
 	//t > snp/length
-	if ((snp/length) > 1e-6) xb[0][0] = 3*snp/length;
+	if ((snp/ctx.length) > 1e-6) xb[0][0] = 3*snp/ctx.length;
 
 	//com.nkappa = 2;
 	for(j=0; j<com.nkappa; j++) { 
@@ -1253,6 +1304,7 @@ int GY94::PairwiseCodon(double space[]) {
 	}
 	
 	GetCodonFreqs(com.pi);	
+	setEqualFreqs();
 	
 	/* initial values and bounds */
 	//divergence time t
@@ -1272,7 +1324,7 @@ int GY94::PairwiseCodon(double space[]) {
 	x[k]=max2(x[k],0.01);
 	x[k]=min2(x[k],2);
 	
-	if ((snp/length) > 1e-6) x[0] = 3.0*snp/length;
+	if ((snp/ctx.length) > 1e-6) x[0] = 3.0*snp/ctx.length;
 
 	ming2(&lnL, x, xb, space, e, com.np);
 	
@@ -1289,7 +1341,7 @@ int GY94::PairwiseCodon(double space[]) {
 
 	lnL = -lnL;
 	//AICc = -2log(lnL) + 2K + 2K(K+1)/(n-K-1), K=parameters' number, n=sample size
-	AICc = -2*lnL + 2.*(com.nkappa+2)*(length/3)/((length/3)-(com.nkappa+2)-1.);
+	AICc = -2*lnL + 2.*(com.nkappa+2)*(ctx.length/3)/((ctx.length/3)-(com.nkappa+2)-1.);
 
 	t = x[0]/3;
 	//kappa = com.kappa;
@@ -1314,6 +1366,16 @@ void GY94::FreeMemPUVR(void){
    //free(PMat); 
 }
 
+void GY94::getMLResult(MLResult &result) {
+
+	getRow(result.row);
+	result.AICc = AICc;
+	copyArray(com.pi, result.freq, (int)CODON);
+	copyArray(KAPPA, result.rate, (int)NUMBER_OF_RATES);
+	result.w = com.omega;
+	result.t = 3.*t;
+}
+
 /* Main fuction for GY method */
 string GY94::Run(const char *seq1, const char *seq2) {
 	
@@ -21,6 +21,7 @@
 #define  GY94_H
 
 #include "base.h"
+#include "Parallel.h"
 
 using namespace std;
 
@@ -28,11 +29,16 @@ class GY94: public Base {
 
 public:	
 	GY94();
-	GY94(string model);
+	GY94(const Context &c);
+	GY94(const Context &c, string model);
 	~GY94();
 	
 	/* Main function */
 	string Run(const char *seq1, const char *seq2);
+	/* Continue random numbers as if 'runs' fits were done by this object */
+	void skipRuns(unsigned long runs);
+	/* Keep the estimates of the last fit for model selection and averaging */
+	void getMLResult(MLResult &result);
 	
 protected:
 	/* Preprocess for calculating Ka&Ks */
@@ -50,8 +56,12 @@ protected:
 	int GetCodonFreqs(double pi[]);	
 	/* Construct transition probability matrix (64*64) */
 	int EigenQc (int getstats, double blength, double *S, double *dS, double *dN, double Root[], double U[], double V[], double kappa[], double omega, double Q[]);
-	/* Return maximum-likelihood score */
+	/* Return maximum-likelihood score, keeping kappa, omega and matrices in the object */
 	double lfun2dSdN (double x[], int np);
+	/* Return maximum-likelihood score, writing only the given kappa and matrices */
+	double lfun2dSdN (double x[], int np, double pkappa[], double Root[], double U[], double V[], double PMat[]);
+	/* Set equal codon frequencies for the models assuming them */
+	void setEqualFreqs();
 	/* Main fuctiion for GY method */
 	int ming2 (double *f, double x[], double xb[][2], double space[], double e, int n);	
 
@@ -88,6 +98,12 @@ public:
 	}  com;
 
 protected:
+	/* Workspace of a likelihood evaluation, one per thread in gradientB */
+	struct LikWork {
+		double KAPPA[8];
+		double PMat[CODON*CODON], U[CODON*CODON], V[CODON*CODON], Root[CODON*CODON];
+	};
+
 	double PMat[CODON*CODON],U[CODON*CODON],V[CODON*CODON],Root[CODON*CODON];
 	int Nsensecodon, FROM61[CODON], FROM64[CODON];
 	int Iround;
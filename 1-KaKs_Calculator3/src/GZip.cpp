@@ -0,0 +1,485 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: GZip.cpp
+* Abstract: Definition of decompressing gzip and BGZF input,
+			BGZF blocks in parallel ahead of the reader.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+
+#include "GZip.h"
+
+#include<fstream>
+#include<iterator>
+#include<string.h>
+#include<unistd.h>
+#include<stdint.h>
+#include<algorithm>
+#include<sys/mman.h>
+#include<zlib.h>
+
+/* Largest length given to zlib at once, whose counters are 32 bits */
+#define GZIP_CHUNK (1u << 30)
+/* Largest ratio of deflate, bounding the content of plain gzip */
+#define GZIP_RATIO 1032
+
+GZip::GZip() {
+	src = NULL;
+	out = NULL;
+	src_size = out_size = out_mapped = 0;
+	page = sysconf(_SC_PAGESIZE);
+	first = ready = next = 0;
+	stream = NULL;
+	in_pos = 0;
+	keep = false;
+	begin = reading = window = 0;
+	ended = failed = stopping = false;
+}
+
+GZip::~GZip() {
+	close();
+}
+
+bool GZip::isGzip(const char *data, size_t size) {
+	return size >= 2 && (unsigned char)data[0] == 0x1f && (unsigned char)data[1] == 0x8b;
+}
+
+/****************************************************
+* Function: readFile
+* Input Parameter: string, string
+* Output: Read the whole file into 'content', decompressed
+		  if it is gzip or BGZF.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool GZip::readFile(string filename, string &content) {
+
+	ifstream is(filename.c_str(), ios::binary);
+	if (!is) return false;
+	content.assign(istreambuf_iterator<char>(is), istreambuf_iterator<char>());
+	is.close();
+
+	if (!isGzip(content.data(), content.length())) return true;
+
+	GZip gz;
+	if (!gz.open(content.data(), content.length())) return false;
+
+	//Copied as it is ready, so the content is not held twice
+	string str;
+	size_t n = 0, m;
+	while ((m = gz.available(n)) > n) {
+		str.append(gz.getData() + n, m - n);
+		gz.release(m);
+		n = m;
+	}
+	if (gz.isFailed()) return false;
+
+	gz.close();
+	content.swap(str);
+
+	return true;
+}
+
+/****************************************************
+* Function: open
+* Input Parameter: const char*, size_t
+* Output: Reserve memory for the content, and start the
+		  threads decompressing it: for BGZF data one for
+		  GZIP_THREAD_SHARE threads of the pool, taking the
+		  blocks in turn, and one for other gzip data.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool GZip::open(const char *data, size_t size) {
+
+	close();
+
+	src = data;
+	src_size = size;
+
+	if (scanBlocks()) {
+		for (size_t i = 0; i < blocks.size(); i++) out_size += blocks[i].size;
+		done.assign(blocks.size(), 0);
+	}
+	else {
+		blocks.clear();
+		stream = new z_stream;
+		memset(stream, 0, sizeof(z_stream));
+		if (inflateInit2(stream, 15 + 16) != Z_OK || src_size > (SIZE_MAX - BGZF_BLOCK_SIZE) / GZIP_RATIO) {
+			cout << "Error in decompressing file..." << endl;
+			close();
+			return false;
+		}
+		out_size = src_size * GZIP_RATIO + BGZF_BLOCK_SIZE;
+		dropped.resize(BGZF_BLOCK_SIZE);
+	}
+
+	//Pages of the content are only allocated when they are written
+	if (out_size > 0) {
+		void *p = mmap(NULL, out_size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+		if (p == MAP_FAILED) {
+			cout << "Error in allocating memory for decompressing..." << endl;
+			close();
+			return false;
+		}
+		out = (char*)p;
+		out_mapped = out_size;
+	}
+
+	restart(0);
+
+	return true;
+}
+
+void GZip::close() {
+
+	//Let the running blocks finish, but take no more
+	stop();
+
+	if (out_mapped > 0) munmap(out, out_mapped);
+	out = NULL;
+	out_size = out_mapped = 0;
+
+	if (stream) {
+		inflateEnd(stream);
+		delete stream;
+		stream = NULL;
+	}
+	in_pos = 0;
+	dropped.clear();
+	keep = false;
+
+	blocks.clear();
+	done.clear();
+	first = ready = next = 0;
+	begin = reading = window = 0;
+	ended = failed = false;
+
+	src = NULL;
+	src_size = 0;
+}
+
+/****************************************************
+* Function: available
+* Input Parameter: size_t
+* Output: Wait until the content is ready beyond 'pos',
+		  widening the window ahead of the reader while it
+		  has to wait.
+* Return Value: Length of the content ready from its start
+*****************************************************/
+size_t GZip::available(size_t pos) {
+
+	unique_lock<mutex> lk(lock);
+	if (pos < begin) {
+		lk.unlock();
+		seek(pos);
+		lk.lock();
+	}
+
+	if (pos > reading) {
+		bool waiting = isAhead();
+		reading = pos;
+		if (waiting && !isAhead()) wanted.notify_all();
+	}
+
+	if (ready <= pos && !ended && !failed) {
+		if (window < GZIP_AHEAD * BGZF_BLOCK_SIZE) {
+			window *= 2;
+			wanted.notify_all();
+		}
+		while (ready <= pos && !ended && !failed) progress.wait(lk);
+	}
+
+	return ready;
+}
+
+/****************************************************
+* Function: release
+* Input Parameter: size_t
+* Output: Free the pages of the content before 'pos', at
+		  least GZIP_RELEASE blocks of it at once.
+* Return Value: void
+*****************************************************/
+void GZip::release(size_t pos) {
+
+	lock_guard<mutex> lk(lock);
+	if (keep) return;
+
+	//Pages wholly before 'pos', all of them ready
+	size_t from = begin / page * page, to = (pos < ready ? pos : ready) / page * page;
+	if (to < from + GZIP_RELEASE * BGZF_BLOCK_SIZE) return;
+
+	madvise(out + from, to - from, MADV_DONTNEED);
+	begin = to;
+}
+
+void GZip::seek(size_t pos) {
+
+	{
+		lock_guard<mutex> lk(lock);
+		if (pos >= begin && pos < ready + window) return;
+	}
+
+	stop();
+	restart(pos);
+}
+
+const char* GZip::getData() {
+	return out;
+}
+
+size_t GZip::getSize() {
+	lock_guard<mutex> lk(lock);
+	return out_size;
+}
+
+bool GZip::isFailed() {
+	lock_guard<mutex> lk(lock);
+	return failed;
+}
+
+/****************************************************
+* Function: scanBlocks
+* Input Parameter: void
+* Output: Find the BGZF blocks by the sizes in their
+		  headers, and the length and CRC of each one's
+		  content from its trailer.
+* Return Value: True if all data is BGZF blocks, otherwise false.
+*****************************************************/
+bool GZip::scanBlocks() {
+
+	size_t p = 0, offset = 0;
+	blocks.clear();
+
+	while (p < src_size) {
+		const unsigned char *h = (const unsigned char*)src + p;
+		//gzip header with extra fields
+		if (src_size - p < 18 || h[0] != 0x1f || h[1] != 0x8b || h[2] != 8 || !(h[3] & 4)) return false;
+
+		size_t xlen = h[10] | (h[11] << 8), bsize = 0;
+		if (12 + xlen > src_size - p) return false;
+
+		//Subfield 'BC' giving the size of the block
+		for (size_t x = 12; x + 4 <= 12 + xlen; ) {
+			size_t slen = h[x+2] | (h[x+3] << 8);
+			if (h[x] == 'B' && h[x+1] == 'C' && slen == 2 && x + 6 <= 12 + xlen) {
+				bsize = (h[x+4] | (h[x+5] << 8)) + 1;
+			}
+			x += 4 + slen;
+		}
+		if (bsize < 12 + xlen + 8 || bsize > src_size - p) return false;
+
+		Block b;
+		b.start = p + 12 + xlen;
+		b.length = bsize - 12 - xlen - 8;
+		b.offset = offset;
+		b.crc = h[bsize-8] | (h[bsize-7] << 8) | (h[bsize-6] << 16) | ((unsigned long)h[bsize-5] << 24);
+		b.size = h[bsize-4] | (h[bsize-3] << 8) | (h[bsize-2] << 16) | ((size_t)h[bsize-1] << 24);
+		if (b.size > BGZF_BLOCK_SIZE) return false;
+
+		blocks.push_back(b);
+		offset += b.size;
+		p += bsize;
+	}
+
+	return blocks.size() > 0;
+}
+
+/****************************************************
+* Function: restart
+* Input Parameter: size_t
+* Output: With the threads stopped, free all content, and
+		  start them again from the block of 'pos'. Plain
+		  gzip goes on if 'pos' is not yet decompressed,
+		  dropping the content before it, or else starts
+		  again and keeps all content from then on.
+* Return Value: void
+*****************************************************/
+void GZip::restart(size_t pos) {
+
+	if (out_mapped > 0 && !keep) madvise(out, out_mapped, MADV_DONTNEED);
+
+	reading = pos;
+	window = BGZF_BLOCK_SIZE;
+
+	int n = 1;
+	if (blocks.size() > 0) {
+		//Last block starting at or before 'pos'
+		size_t i = upper_bound(blocks.begin(), blocks.end(), pos,
+			[](size_t p, const Block &b) { return p < b.offset; }) - blocks.begin();
+		i = i > 0 ? i - 1 : 0;
+		first = next = i;
+		ready = begin = blocks[i].offset;
+		for (size_t j = i; j < done.size(); j++) done[j] = 0;
+		ended = false;
+		n = TaskGroup::getThreads() / GZIP_THREAD_SHARE;
+		if (n < 1) n = 1;
+	}
+	else if (pos < ready || keep) {
+		if (!keep && ready > 0) keep = true;
+		if (pos < ready) {
+			inflateReset(stream);
+			stream->avail_in = 0;
+			in_pos = 0;
+			ready = 0;
+			ended = false;
+		}
+		begin = keep ? 0 : pos;
+	}
+	else {
+		begin = pos;
+	}
+
+	if (ended || failed) return;
+	for (int i = 0; i < n; i++) threads.push_back(thread(&GZip::work, this));
+}
+
+void GZip::stop() {
+
+	{
+		lock_guard<mutex> lk(lock);
+		stopping = true;
+		wanted.notify_all();
+	}
+	for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+	threads.clear();
+	stopping = false;
+}
+
+bool GZip::isAhead() {
+
+	if (blocks.size() > 0) return next < blocks.size() && blocks[next].offset >= reading + window;
+	return ready >= begin && ready >= reading + window;
+}
+
+/****************************************************
+* Function: work
+* Input Parameter: void
+* Output: Take the next block while it is in the window,
+		  and move the ready length over the blocks done.
+* Return Value: void
+*****************************************************/
+void GZip::work() {
+
+	unique_lock<mutex> lk(lock);
+	while (true) {
+		while (!stopping && !ended && !failed && isAhead()) wanted.wait(lk);
+		if (stopping || ended || failed) return;
+
+		bool ok;
+		if (blocks.size() > 0) {
+			if (next >= blocks.size()) return;
+			size_t i = next++;
+			lk.unlock();
+			ok = inflateBlock(i);
+			lk.lock();
+			if (ok) {
+				done[i] = 1;
+				while (first < blocks.size() && done[first]) ready += blocks[first++].size;
+				ended = (first == blocks.size());
+			}
+			else if (!failed) {
+				cout << "Error in decompressing block " << i + 1 << "..." << endl;
+			}
+		}
+		else {
+			//One thread for plain gzip, going on from the content ready
+			size_t offset = ready, drop = begin > ready ? begin - ready : 0, length = 0;
+			bool end = false;
+			lk.unlock();
+			ok = inflateChunk(offset, drop, length, end);
+			lk.lock();
+			if (ok) {
+				ready += length;
+				if (end) {
+					ended = true;
+					out_size = ready;
+				}
+			}
+			else if (!failed) {
+				cout << "Error in decompressing file..." << endl;
+			}
+		}
+
+		if (!ok) failed = true;
+		progress.notify_all();
+	}
+}
+
+/****************************************************
+* Function: inflateBlock
+* Input Parameter: size_t
+* Output: Decompress a block into its place, checking its
+		  length and CRC.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool GZip::inflateBlock(size_t i) {
+
+	Block &b = blocks[i];
+	char empty;
+
+	z_stream zs;
+	memset(&zs, 0, sizeof(zs));
+	bool ok = (inflateInit2(&zs, -15) == Z_OK);
+	if (ok) {
+		zs.next_in = (Bytef*)(src + b.start);
+		zs.avail_in = b.length;
+		zs.next_out = (Bytef*)(b.size > 0 ? out + b.offset : &empty);
+		zs.avail_out = b.size;
+		ok = (inflate(&zs, Z_FINISH) == Z_STREAM_END && zs.total_out == b.size);
+		inflateEnd(&zs);
+		ok = ok && crc32(0L, (const Bytef*)(b.size > 0 ? out + b.offset : &empty), b.size) == b.crc;
+	}
+
+	return ok;
+}
+
+/****************************************************
+* Function: inflateChunk
+* Input Parameter: size_t, size_t, size_t, bool
+* Output: Decompress gzip data of one or more members into
+		  the content at 'offset', up to a block, or the
+		  first 'drop' bytes of it into 'dropped'.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool GZip::inflateChunk(size_t offset, size_t drop, size_t &length, bool &end) {
+
+	size_t n = BGZF_BLOCK_SIZE;
+	char *to = out + offset;
+	if (drop > 0) {
+		to = &dropped[0];
+		if (drop < n) n = drop;
+	}
+	if (out_mapped - offset < n) n = out_mapped - offset;
+	if (n == 0) return false;
+
+	z_stream_s *zs = stream;
+	zs->next_out = (Bytef*)to;
+	zs->avail_out = n;
+
+	end = false;
+	while (zs->avail_out > 0) {
+		if (zs->avail_in == 0 && in_pos < src_size) {
+			zs->next_in = (Bytef*)(src + in_pos);
+			zs->avail_in = src_size - in_pos < GZIP_CHUNK ? src_size - in_pos : GZIP_CHUNK;
+			in_pos += zs->avail_in;
+		}
+
+		int ret = inflate(zs, Z_NO_FLUSH);
+		if (ret == Z_STREAM_END) {
+			//Members concatenated one after another
+			const char *rest = (const char*)zs->next_in;
+			if (isGzip(rest, src + src_size - rest)) {
+				inflateReset(zs);
+				continue;
+			}
+			end = true;
+			break;
+		}
+		if (ret != Z_OK) return false;
+	}
+	length = n - zs->avail_out;
+
+	return true;
+}
@@ -0,0 +1,129 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: GZip.h
+* Abstract: Declaration of decompressing gzip and BGZF input,
+			BGZF blocks in parallel ahead of the reader.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+#if !defined(GZIP_H)
+#define  GZIP_H
+
+#include<string>
+#include<iostream>
+#include<vector>
+#include<mutex>
+#include<condition_variable>
+#include<thread>
+
+#include "Parallel.h"
+
+using namespace std;
+
+/* Maximal size of a BGZF block, both compressed and decompressed */
+#define BGZF_BLOCK_SIZE 65536
+/* Most blocks decompressed ahead of the reader, and the least to free behind it */
+#define GZIP_AHEAD 64
+#define GZIP_RELEASE 16
+/* Threads of the pool for each thread decompressing BGZF blocks */
+#define GZIP_THREAD_SHARE 4
+
+struct z_stream_s;
+
+/* Content of gzip data, decompressed by its own threads into memory reserved for
+   all of it. The threads keep a window of blocks ahead of the reader, and the pages
+   of the content before the reader are freed as it goes, so only the window is held */
+class GZip {
+
+public:
+	GZip();
+	~GZip();
+
+	/* Whether the data starts with the magic bytes of gzip */
+	static bool isGzip(const char *data, size_t size);
+	/* Read a file, decompressing it if it is gzip */
+	static bool readFile(string filename, string &content);
+
+	/* Start decompressing the data, which is kept until 'close' */
+	bool open(const char *data, size_t size);
+	/* Wait for the running blocks and free the content */
+	void close();
+
+	/* Get the length of the content ready from its start, waiting until it is more
+	   than 'pos' or all of it; less if a block failed */
+	size_t available(size_t pos);
+	/* Free the content before 'pos', which is no longer viewed */
+	void release(size_t pos);
+	/* Go on reading from 'pos', decompressing again from the block of it if the
+	   content there is freed or far ahead. Plain gzip can only be decompressed from
+	   its start, so once read back, all of its content is kept */
+	void seek(size_t pos);
+
+	const char* getData();
+	/* Length of the content; for plain gzip, of the memory reserved until its end */
+	size_t getSize();
+	bool isFailed();
+
+protected:
+	/* Find the blocks, false if the data is not BGZF */
+	bool scanBlocks();
+	/* Free the content and start the threads from the block of 'pos' */
+	void restart(size_t pos);
+	/* Stop the threads after their running blocks */
+	void stop();
+	/* Loop of a thread: decompress the blocks in the window */
+	void work();
+	/* Whether the next block is beyond the window ahead of the reader */
+	bool isAhead();
+	/* Decompress a BGZF block into its place */
+	bool inflateBlock(size_t i);
+	/* Decompress at most a block of plain gzip into the content at 'offset', or drop
+	   its first 'drop' bytes; 'length' gets its length and 'end' whether the data ends */
+	bool inflateChunk(size_t offset, size_t drop, size_t &length, bool &end);
+
+	/* Compressed data */
+	const char *src;
+	size_t src_size;
+
+	/* Content, in memory mapped for all of it, whose pages are allocated as they are written */
+	char *out;
+	size_t out_size;
+	size_t out_mapped;
+	size_t page;
+
+	/* A BGZF block: offset and length of the deflated data, offset, length and CRC of the content */
+	struct Block {
+		size_t start, length, offset, size;
+		unsigned long crc;
+	};
+	vector<Block> blocks;
+	/* Whether each block is decompressed */
+	vector<char> done;
+	/* First block not yet ready and the length of the content before it */
+	size_t first, ready;
+	/* Next block to take */
+	size_t next;
+
+	/* Stream of plain gzip, the input given to it, and a block dropped before 'begin' */
+	z_stream_s *stream;
+	size_t in_pos;
+	vector<char> dropped;
+	/* Whether all content is kept, after reading back plain gzip */
+	bool keep;
+
+	/* Content before it is freed */
+	size_t begin;
+	/* Farthest offset the reader waited for, and the length decompressed ahead of it,
+	   growing while the reader goes on */
+	size_t reading, window;
+	bool ended, failed, stopping;
+
+	mutex lock;
+	condition_variable progress, wanted;
+	vector<thread> threads;
+};
+
+#endif
@@ -79,11 +79,23 @@ KAKS::~KAKS() {
 int KAKS::Initialize() {
 
     none = ng86 = lpb93 = lwl85 = mlwl85 = mlpb93 = yn00 = gy94 = myn06 = ms06 = ma06 = false;
-    result4Win = result = seq_name = seq1 = seq2 = "";
+    result4Win = result = "";
     seq_filename = output_filename = detail_filename = "";
-    result = details = "";
-    genetic_code = 1;
+    pairs_filename = maf_species = "";
+    result = "";
+    ctx = Context();
     number = 0;
+    threads = 1;
+    shard = records = "";
+    first_record = last_record = 0;
+    serve_port = 0;
+    worker_address = "";
+    checkpoint_interval = -1;
+    flush_interval = WRITER_INTERVAL;
+    resume = false;
+    bgzf = false;
+    binary = false;
+    output_length = detail_length = 0;
 
     return 1;
 }
@@ -93,6 +105,10 @@ int KAKS::Uninitialize() {
     if (os.is_open()) {
         os.close();
     }
+    zos.close();
+    cos.close();
+    dos.close();
+    zds.close();
 
 	hh = mm = ss = 0;
 
@@ -106,6 +122,15 @@ string KAKS::getResult4Win() {
 	return "";
 }
 
+void KAKS::keepResult4Win() {
+	result_sink = [this](const string &rows) {
+		//add a lock "isOK4Win" to avoid the program collapse
+		isOK4Win = false;
+		result4Win += rows;
+		isOK4Win = true;
+	};
+}
+
 /****************************************************
  * Function: ReadCalculateSeq
  * Input Parameter: string
@@ -113,7 +138,20 @@ string KAKS::getResult4Win() {
                   and calculate Ka and Ks.
  * Return Value: True if succeed, otherwise false.
  
- * Note: Using axt file for low memory
+ * Note: Using axt file for low memory. A reader thread
+ *       parses records, the pool checks and calculates
+ *       them, and a writer thread writes results in the
+ *       input order; queues of bounded size connect them.
+ *       With --shard or --records, the reader seeks to the
+ *       first selected record by the index of axt file.
+ *       With --pairs, the input is FASTA file loaded once,
+ *       and the records are the lines of the list of pairs.
+ *       With --maf, the records are the pairs of species in
+ *       the blocks of MAF file, read as they are needed.
+ *       With --serve-work, the pairs are calculated by the
+ *       connected workers instead of the pool. With
+ *       --checkpoint, the writer saves the progress, from
+ *       which --resume continues.
  *****************************************************/
 bool KAKS::ReadCalculateSeq(string filename) {
 
@@ -123,53 +161,191 @@ bool KAKS::ReadCalculateSeq(string filename) {
     bool flag = true;
 
     try {
-		ifstream is(filename.c_str());
-		if (!is) {
+		//Records of axt file, pairs of the list with FASTA file, or pairs in blocks of MAF file
+		AXTReader axt;
+		PairReader pairs;
+		MAFReader maf;
+		bool listed = (pairs_filename != ""), aligned = (maf_species != "");
+		AXTReader &input = listed ? pairs : (aligned ? (AXTReader&)maf : axt);
+		if (!(listed ? pairs.open(filename, pairs_filename) : (aligned ? maf.open(filename, maf_species) : axt.open(filename)))) {
 			cout << "Error in opening file..." << endl;
 			throw 1;
 		}
 
+		//Offset of the selected records
+		long long start = 0;
+		bool slice = (shard != "" || records != "");
+		if (slice) {
+			AXTIndex index;
+			if (!(listed ? pairs.index(index) : (aligned ? maf.index(index) : index.load(filename))) ||
+				!index.select(shard, records, first_record, last_record)) {
+				throw 1;
+			}
+			if (first_record < index.offsets.size()) start = index.offsets[first_record];
+		}
+
 		showParaInfo();	//Show information on display
 
 		result = getTitleInfo();
 
-		//Output stream
-		if (output_filename != "" && output_filename.length() > 0) {
-			os.open(output_filename.c_str());
+		//Continue after the records done, or start from the first one
+		unsigned long done = 0;
+		bool resumed = resume && checkpoint.load(output_filename + CHECKPOINT_SUFFIX);
+		if (resumed) {
+			if (!restoreCheckpoint(done, start)) throw 1;
 		}
+		else if (resume) {
+			cout << "No checkpoint found, starting from the first record..." << endl;
+		}
+		if (start > 0) input.seek(start);
 
-		string temp = "", name = "", str = "";
-
-		while (getline(is, temp, '\n')) {
-			name = temp;
-			str = "";
-
-			getline(is, temp, '\n');
-			while (temp != "") {
-				str += temp;
-				getline(is, temp, '\n');
+		//Output stream, appended to the part written before the checkpoint
+		if (output_filename != "" && output_filename.length() > 0) {
+			if (bgzf) {
+				if (!zos.open(output_filename, resumed)) throw 1;
+				zos.write(result);
+				result = "";
+			}
+			else if (binary) {
+				if (!cos.open(output_filename, result, resumed)) throw 1;
+				result = "";
 			}
+			else os.open(output_filename, resumed, flush_interval);
+		}
+		if (detail_filename != "" && !openDetails(resumed)) {
+			cout << "Error in writing to file..." << endl;
+			throw 1;
+		}
 
-			//string msg = "";
-			//if (checkPairwiseCoding(str, msg)) {
-			if (checkValid(name, str)) {
-				cout << "[" << ++number << "] " << name << "\t";
-				bool isOK = calculateKaKs();
-				if (isOK == false) {
-					cout << "[Error in calculating]";
-					throw 1;
+		//Queues between the stages, whose bounds cap the pairs kept in memory.
+		//Pairs in flight are a window for starting the costly ones first,
+		//or for keeping all workers busy.
+		BoundedQueue<KaKsPair*> records(4 * threads), pending(serve_port > 0 ? 1024 : 16 * threads);
+		mutex lock;
+		condition_variable finished;
+		bool isOK = true;
+
+		//Coordinator: workers send back the results of the pairs
+		WorkServer server(getWorkConf());
+		map<unsigned long, KaKsPair*> sent;
+		unsigned long jobs = 0;
+		if (serve_port > 0) {
+			server.onReply = [&](unsigned long id, vector<string> &reply) {
+				lock_guard<mutex> lk(lock);
+				KaKsPair *pair = sent[id];
+				sent.erase(id);
+				//No reply if the pair failed on every worker tried, e.g. crashing
+				//them, which is reported as an invalid pair and the others go on
+				if (reply.size() == 5) {
+					pair->valid = (reply[0] == "1");
+					pair->ok = (reply[1] == "1");
+					pair->msg = reply[2];
+					pair->result = reply[3];
+					pair->details = reply[4];
 				}
 				else {
-					cout << "[OK]";
+					pair->valid = pair->ok = false;
+					pair->msg = "[Error. " + pair->name + " failed on every worker tried.]";
+				}
+				pair->done = true;
+				finished.notify_all();
+			};
+			if (!server.start(serve_port)) throw 1;
+		}
+
+		//Reader: parse the records of axt file
+		thread reader([&]() {
+			AXTRecord rec;
+			unsigned long n = done;
+			while ((!slice || n++ < last_record - first_record) && input.next(rec)) {
+				KaKsPair *pair = new KaKsPair();
+				pair->name = string(rec.name);
+				pair->setRecord(rec);
+				pair->end = rec.end;
+				if (listed) pair->msg = pairs.msg;
+
+				if (!records.push(pair)) {
+					delete pair;
+					break;
 				}
 			}
-			//else {
-			//	cout << msg.c_str();
-			//}
-			cout << endl;
+			records.close();
+		});
+
+		//Writer: write the results in the input order
+		thread writer([&]() {
+			KaKsPair *pair;
+			while (pending.pop(pair)) {
+				{
+					unique_lock<mutex> lk(lock);
+					while (!pair->done) finished.wait(lk);
+				}
+				if (isOK && !writeResult(*pair)) {
+					//Stop reading, and free the pairs left
+					isOK = false;
+					records.close();
+					pending.close();
+				}
+				else if (isOK && checkpoint.isDue(checkpoint_interval)) {
+					saveCheckpoint(done + 1, pair->end);
+				}
+				if (isOK) done++;
+				delete pair;
+			}
+		});
+
+		//Check and calculate the pairs in parallel
+		TaskGroup group;
+		KaKsPair *pair;
+		while (records.pop(pair)) {
+			if (!pending.push(pair)) {
+				delete pair;
+				break;
+			}
+			//Pair found invalid when read, e.g. a name not in FASTA file
+			if (pair->msg != "") {
+				lock_guard<mutex> lk(lock);
+				pair->done = true;
+				finished.notify_all();
+				continue;
+			}
+			if (serve_port > 0) {
+				vector<string> request;
+				request.push_back(pair->name);
+				request.push_back(pair->getString());
+				pair->clearSequences();
+				{
+					lock_guard<mutex> lk(lock);
+					sent[++jobs] = pair;
+				}
+				server.submit(jobs, request);
+				continue;
+			}
+			double cost = estimateCost(pair->length / 2);
+			group.run([this, pair, &lock, &finished]() {
+				bool valid = checkValid(*pair);
+				pair->clearSequences();
+				bool ok = valid && calculateKaKs(*pair);
+
+				lock_guard<mutex> lk(lock);
+				pair->valid = valid;
+				pair->ok = ok;
+				pair->done = true;
+				finished.notify_all();
+			}, cost);
 		}
-		is.close();
-		is.clear();
+		pending.close();
+		records.close();
+
+		reader.join();
+		while (records.pop(pair)) delete pair;
+		group.wait();
+		if (serve_port > 0) server.finish();
+		writer.join();
+
+		if (isOK == false || input.isFailed()) throw 1;
+
+		input.close();
     } catch (...) {
         flag = false;
     }
@@ -183,65 +359,343 @@ bool KAKS::ReadCalculateSeq(string filename) {
     return flag;
 }
 
+/**************************************************
+ * Function: estimateCost
+ * Input Parameter: unsigned long
+ * Output: Estimate the time for calculating a pair of
+                  given length with the selected methods.
+ * Return Value: Relative cost, about in milliseconds
+ 
+ * Note: A maximum likelihood fit (GY, and each candidate
+ *       model of MS/MA) costs much more than counting
+ *       methods, and mostly regardless of the length.
+ ***************************************************/
+double KAKS::estimateCost(unsigned long len) {
+
+	double codons = len / 3.0, cost = 0.0;
+
+	//Counting methods
+	cost += (none + ng86 + lwl85 + mlwl85 + lpb93 + mlpb93) * (1.0 + 0.001 * codons);
+	if (yn00) cost += 2.0 + 0.003 * codons;
+	if (myn06) cost += 3.0 + 0.004 * codons;
+
+	//Maximum likelihood methods
+	int fits = gy94;
+	if (ms06 || ma06) fits += MODELCOUNT + ma06;
+	cost += fits * (50.0 + 0.03 * codons);
+
+	return cost;
+}
+
+/**************************************************
+ * Function: writeResult
+ * Input Parameter: KaKsPair
+ * Output: Show the state of a pair on display and write
+                  its results into file, in the input order.
+ * Return Value: True if succeed, otherwise false.
+ ***************************************************/
+bool KAKS::writeResult(KaKsPair &pair) {
+
+	if (!pair.valid) {
+		cout << pair.msg << endl;
+		return true;
+	}
+
+	pair.id = ++number;
+	cout << "[" << pair.id << "] " << pair.name << "\t";
+	if (pair.ok == false) {
+		cout << "[Error in calculating]";
+		return false;
+	}
+	cout << "[OK]" << endl;
+
+	result += pair.result;
+	if (result_sink) result_sink(result);
+
+	//Details of the pair, indexed by its name with --bgzf
+	if (zds.is_open()) {
+		zds.addRecord(pair.name);
+		zds.write(pair.details);
+	}
+	else if (dos.is_open()) {
+		dos.write(pair.details);
+		detail_length += pair.details.length();
+	}
+
+	//Write into the file
+	if (output_filename.length() > 0 && zos.is_open()) {
+		zos.addRecord(pair.name);
+		zos.write(result);
+	}
+	else if (output_filename.length() > 0 && cos.is_open()) {
+		for (unsigned long i = 0; i < pair.rows.size(); i++) cos.add(pair.rows[i]);
+	}
+	else if (output_filename.length() > 0 && os.is_open()) {
+		os.write(result);
+		output_length += result.length();
+	}
+	result = "";
+
+	return true;
+}
+
+/**************************************************
+ * Function: saveCheckpoint
+ * Input Parameter: unsigned long, long long
+ * Output: Save the records written and the offset of input
+ *         file after them, with the lengths of outputs, all
+ *         written into the files first.
+ * Return Value: True if succeed, otherwise false.
+ ***************************************************/
+bool KAKS::saveCheckpoint(unsigned long done, long long offset) {
+
+	vector<string> conf = getWorkConf();
+
+	checkpoint.set("program", KAKS_NAME);
+	checkpoint.set("input", getInputName());
+	checkpoint.set("methods", conf[3] + " " + conf[2]);
+	checkpoint.set("selection", shard + records);
+	checkpoint.setInteger("offset", offset);
+	checkpoint.setInteger("records", done);
+	checkpoint.setInteger("number", number);
+
+	//Blocks of BGZF output are written whole, with the index
+	if (zos.is_open()) {
+		if (!zos.flush()) return false;
+		output_length = zos.getLength();
+	}
+	else if (cos.is_open()) {
+		if (!cos.flush()) return false;
+		output_length = cos.getLength();
+	}
+	else if (os.is_open() && !os.flush()) {
+		return false;
+	}
+	checkpoint.setInteger("output", output_length);
+
+	if (zds.is_open()) {
+		if (!zds.flush()) return false;
+		detail_length = zds.getLength();
+	}
+	else if (dos.is_open() && !dos.flush()) {
+		return false;
+	}
+	checkpoint.setInteger("detail_output", detail_length);
+
+	return checkpoint.save(output_filename + CHECKPOINT_SUFFIX);
+}
+
+/**************************************************
+ * Function: restoreCheckpoint
+ * Input Parameter: unsigned long, long long
+ * Output: Check that the checkpoint is of the same run,
+ *         cut the outputs to their lengths at the checkpoint
+ *         and restore the count of pairs.
+ * Return Value: True if succeed, otherwise false.
+ ***************************************************/
+bool KAKS::restoreCheckpoint(unsigned long &done, long long &offset) {
+
+	bool flag = true;
+
+	try {
+		vector<string> conf = getWorkConf();
+		if (checkpoint.get("program") != KAKS_NAME || checkpoint.get("input") != getInputName() ||
+			checkpoint.get("methods") != conf[3] + " " + conf[2] || checkpoint.get("selection") != shard + records) {
+			cout << "Error. The checkpoint is of another run." << endl;
+			throw 1;
+		}
+
+		offset = checkpoint.getInteger("offset");
+		done = (unsigned long)checkpoint.getInteger("records");
+		number = (unsigned long)checkpoint.getInteger("number");
+		output_length = checkpoint.getInteger("output");
+
+		if (!Checkpoint::truncateFile(output_filename, output_length) && output_length > 0) throw 1;
+		if (output_length > 0) result = "";
+
+		detail_length = checkpoint.getInteger("detail_output");
+		if (detail_filename != "" && !Checkpoint::truncateFile(detail_filename, detail_length) && detail_length > 0) throw 1;
+
+		cout << "Resuming after " << done << " records..." << endl;
+	}
+	catch (...) {
+		cout << "Error in resuming from checkpoint..." << endl;
+		flag = false;
+	}
+
+	return flag;
+}
+
+/**************************************************
+ * Function: openDetails
+ * Input Parameter: bool
+ * Output: Open the details for model selection, as BGZF
+ *         indexed by pair with --bgzf, and write the title
+ *         unless appending after it. The pairs are written
+ *         as they are done, so that no details are kept.
+ * Return Value: True if succeed, otherwise false.
+ ***************************************************/
+bool KAKS::openDetails(bool append) {
+
+	string title = getTitleInfo();
+
+	if (bgzf) {
+		if (!zds.open(detail_filename, append)) return false;
+		if (zds.getLength() == 0) zds.write(title);
+	}
+	else {
+		if (!dos.open(detail_filename, append && detail_length > 0, flush_interval)) return false;
+		if (detail_length == 0) {
+			dos.write(title);
+			detail_length = title.length();
+		}
+	}
+
+	return true;
+}
+
+/**************************************************
+ * Function: getWorkConf
+ * Input Parameter:
+ * Output: Get the configuration for workers: version,
+ *         genetic code and the methods selected.
+ * Return Value: vector
+ ***************************************************/
+vector<string> KAKS::getWorkConf() {
+
+	bool flags[] = {none, ng86, lwl85, mlwl85, lpb93, mlpb93, gy94, yn00, myn06, ms06, ma06};
+	string methods = "";
+	for (int i = 0; i < sizeof(flags) / sizeof(bool); i++) methods += flags[i] ? '1' : '0';
+
+	vector<string> conf;
+	conf.push_back("CONF");
+	conf.push_back(VERSION);
+	conf.push_back(CONVERT<string>(ctx.genetic_code));
+	conf.push_back(methods);
+
+	return conf;
+}
+
+bool KAKS::setWorkConf(const vector<string> &conf) {
+
+	if (conf.size() != 4 || conf[0] != "CONF" || conf[1] != VERSION || conf[3].length() != 11) return false;
+
+	ctx.genetic_code = CONVERT<int>(conf[2]);
+	if (ctx.genetic_code < 1 || ctx.genetic_code > NCODE) return false;
+
+	bool *flags[] = {&none, &ng86, &lwl85, &mlwl85, &lpb93, &mlpb93, &gy94, &yn00, &myn06, &ms06, &ma06};
+	for (int i = 0; i < conf[3].length(); i++) *flags[i] = (conf[3][i] == '1');
+
+	return true;
+}
+
+/****************************************************
+ * Function: RunWorker
+ * Input Parameter: string
+ * Output: Connect to a coordinator at "host:port", and
+ *         calculate the pairs it sends, by checkValid and
+ *         calculateKaKs as for a file, until it stops.
+ * Return Value: True if succeed, otherwise false.
+ *****************************************************/
+bool KAKS::RunWorker(string address) {
+
+	bool flag = true;
+	int fd = -1;
+
+	try {
+		programInfo();
+
+		fd = connectTo(address);
+		if (fd < 0) {
+			cout << "Error in connecting to " << address << "..." << endl;
+			throw 1;
+		}
+
+		vector<string> msg;
+		if (!recvMessage(fd, msg) || !setWorkConf(msg)) {
+			cout << "Error in configuration from " << address << "..." << endl;
+			throw 1;
+		}
+		cout << "Calculating pairs for " << address << "..." << endl;
+
+		//Ask for two pairs per thread, so that the next one is at hand
+		vector<string> hello;
+		hello.push_back("HELLO");
+		hello.push_back(CONVERT<string>(2 * threads));
+		if (!sendMessage(fd, hello)) throw 1;
+
+		mutex lock;
+		TaskGroup group;
+		while (recvMessage(fd, msg) && msg.size() == 4 && msg[0] == "PAIR") {
+			KaKsPair *pair = new KaKsPair();
+			string id = msg[1];
+			pair->name = msg[2];
+			pair->str = msg[3];
+			pair->setString();
+			number++;
+
+			group.run([this, pair, id, fd, &lock]() {
+				pair->valid = checkValid(*pair);
+				pair->clearSequences();
+				pair->ok = pair->valid && calculateKaKs(*pair);
+
+				vector<string> reply;
+				reply.push_back("DONE");
+				reply.push_back(id);
+				reply.push_back(pair->valid ? "1" : "0");
+				reply.push_back(pair->ok ? "1" : "0");
+				reply.push_back(pair->msg);
+				reply.push_back(pair->result);
+				reply.push_back(pair->details);
+				delete pair;
+
+				lock_guard<mutex> lk(lock);
+				sendMessage(fd, reply);
+			}, estimateCost(pair->length / 2));
+		}
+		group.wait();
+
+		//Stopped by the coordinator, or else lost it
+		if (msg.size() != 1 || msg[0] != "STOP") {
+			cout << "Connection to " << address << " lost..." << endl;
+			throw 1;
+		}
+		cout << "Mission accomplished. (Pairs calculated: " << number << ")" << endl;
+	}
+	catch (...) {
+		flag = false;
+	}
+
+	if (fd >= 0) closeConnection(fd);
+
+	return flag;
+}
+
 /**************************************************
  * Function: checkValid
- * Input Parameter: string, string
+ * Input Parameter: KaKsPair
  * Output: Check validity of pairwise sequences
  * Return Value: True if succeed, otherwise false. 
  ***************************************************/
-bool KAKS::checkValid(string name, string str) {
+bool KAKS::checkValid(KaKsPair &pair) {
     bool flag = true;
-    long i;
 
     try {
 
 		//Check whether sequences are equal in length
-		if (str.length() % 2 !=0) {
-			cout << "[Error. The sequences are not equal in length.]";
+		if (pair.length % 2 !=0) {
+			pair.msg = "[Error. The sequences are not equal in length.]";
 			throw 1;
 		}
 
-		string str1 = str.substr(0, str.length() / 2);
-		string str2 = str.substr(str.length() / 2, str.length() / 2);
-
         //Check whether (sequence length)/3==0
-		if (str1.length() % 3 != 0 || str2.length() % 3 != 0) {
-			cout << "[Error. The sequences are not codon-based alignment.]";
+		if (pair.half1.length() % 3 != 0 || pair.half2.length() % 3 != 0) {
+			pair.msg = "[Error. The sequences are not codon-based alignment.]";
 			throw 1;
 		}
 
-        //Delete gap and stop codon
-        bool found;
-        int j;
-        for (i = 0; i < str1.length(); i += 3) {
-            for (found = false, j = 0; j < 3 && !found; j++) {
-                if (str1[j + i] == '-' || str2[j + i] == '-') {
-                    found = true;
-                }
-                str1[i + j] = toupper(str1[i + j]);
-                str2[i + j] = toupper(str2[i + j]);
-                if (convertChar(str1[i + j]) == -1 || convertChar(str2[i + j]) == -1) {
-                    found = true;
-                }
-            }
-
-            if ((getAminoAcid(str1.substr(i, 3)) == '!') || (getAminoAcid(str2.substr(i, 3)) == '!')) {
-                found = true;
-            }
-
-            if (found) {
-                str1 = str1.replace(i, 3, "");
-                str2 = str2.replace(i, 3, "");
-                i -= 3;
-            }
-        }
-
-        //pass value into private variables
-        seq1 = str1;
-        seq2 = str2;
-        //pass value into extern variables
-        seq_name = name;
-        length = str1.length();
+        //Delete gap and stop codon, and pass value into the pair
+        filterCodons(pair.half1, pair.half2, pair.seq1, pair.seq2);
     } catch (...) {
         flag = false;
     }
@@ -265,17 +719,34 @@ bool KAKS::Run(int argc, const char* argv[]) {
             throw 1;
         }
 
+        //Threads for calculating pairs
+        TaskGroup::setThreads(threads);
+
+        //Worker: calculate the pairs of a coordinator
+        if (worker_address != "") {
+            if (!RunWorker(worker_address)) throw 1;
+            return flag;
+        }
+
         //Read sequences and calculate Ka & Ks
-		ReadCalculateSeq(seq_filename);
+		bool finished = ReadCalculateSeq(seq_filename);
         
 		//Output results
 		cout << "Outputing results: ";
 		cout << output_filename;
-        //Write details for model-selected method
-		if ( writeFile(detail_filename, (getTitleInfo() + details).c_str())==true) {
+        if (!os.close() || !zos.close() || !cos.close()) finished = false;
+
+        //Details for model-selected method
+		if (dos.close() && zds.close()) {
 			cout << "\t" << detail_filename;
 		}
 		cout << endl;
+		if (!finished) throw 1;
+
+        //A finished run needs no checkpoint
+        if (finished && checkpoint_interval >= 0) {
+            Checkpoint::remove(output_filename + CHECKPOINT_SUFFIX);
+        }
 
         //Print on display
         cout << "Mission accomplished. (Time elapsed: ";
@@ -340,8 +811,8 @@ bool KAKS::parseParameter(int argc, const char* argv[]) {
                 }//Genetic Code Table
                 else if (temp == "-C") {
                     if ((i + 1) < argc && codeflag == 0) {
-                        genetic_code = CONVERT<int>(argv[++i]);
-                        if (genetic_code < 1 || genetic_code > NCODE || strlen(transl_table[2 * (genetic_code - 1)]) < 1)
+                        ctx.genetic_code = CONVERT<int>(argv[++i]);
+                        if (ctx.genetic_code < 1 || ctx.genetic_code > NCODE || strlen(transl_table[2 * (ctx.genetic_code - 1)]) < 1)
                             throw 1;
                         codeflag++;
                     } else {
@@ -352,6 +823,56 @@ bool KAKS::parseParameter(int argc, const char* argv[]) {
                     if ((i + 1) > argc) throw 1;
                     detail_filename = argv[++i];
 
+                }//Number of threads
+                else if (temp == "-T") {
+                    if ((i + 1) >= argc) throw 1;
+                    threads = CONVERT<int>(argv[++i]);
+                    if (threads < 1) throw 1;
+                }//Records selected from the index of axt file
+                else if (temp == "--SHARD") {
+                    if ((i + 1) >= argc || records != "") throw 1;
+                    shard = argv[++i];
+                }
+                else if (temp == "--RECORDS") {
+                    if ((i + 1) >= argc || shard != "") throw 1;
+                    records = argv[++i];
+                }//Pairs of sequences in FASTA file
+                else if (temp == "--PAIRS") {
+                    if ((i + 1) >= argc || maf_species != "") throw 1;
+                    pairs_filename = argv[++i];
+                }//Pairs of species in blocks of MAF file
+                else if (temp == "--MAF") {
+                    if ((i + 1) >= argc || pairs_filename != "") throw 1;
+                    maf_species = argv[++i];
+                    if (stringtoUpper(maf_species) == MAF_ALL_PAIRS) maf_species = MAF_ALL_PAIRS;
+                }//Serve pairs to workers, or be a worker
+                else if (temp == "--SERVE-WORK") {
+                    if ((i + 1) >= argc || worker_address != "") throw 1;
+                    serve_port = CONVERT<int>(argv[++i]);
+                    if (serve_port < 1 || serve_port > 65535) throw 1;
+                }
+                else if (temp == "--WORKER") {
+                    if ((i + 1) >= argc || serve_port > 0) throw 1;
+                    worker_address = argv[++i];
+                }//Checkpoints of progress
+                else if (temp == "--CHECKPOINT") {
+                    if ((i + 1) >= argc) throw 1;
+                    checkpoint_interval = CONVERT<int>(argv[++i]);
+                    if (checkpoint_interval < 0) throw 1;
+                }
+                else if (temp == "--RESUME") {
+                    resume = true;
+                }
+                else if (temp == "--FLUSH-INTERVAL") {
+                    if ((i + 1) >= argc) throw 1;
+                    flush_interval = CONVERT<int>(argv[++i]);
+                    if (flush_interval < 0) throw 1;
+                }
+                else if (temp == "--BGZF") {
+                    bgzf = true;
+                }
+                else if (temp == "--BINARY") {
+                    binary = true;
                 }//Algorithm(s) selected
                 else if (temp == "-M") {
                     if ((i + 1) > argc) throw 1;
@@ -373,8 +894,14 @@ bool KAKS::parseParameter(int argc, const char* argv[]) {
                 } else throw 1;
             }
 
-            //If no input or output file, report error
-            if (inputflag == 0 || outputflag == 0) throw 1;
+            //If no input or output file, report error, except for a worker
+            if (worker_address == "" && (inputflag == 0 || outputflag == 0)) throw 1;
+
+            //Binary output is written here, neither compressed nor served
+            if (binary && (bgzf || serve_port > 0)) throw 1;
+
+            //Keep saving checkpoints when resuming
+            if (resume && checkpoint_interval < 0) checkpoint_interval = 60;
 
             //Default: use ma to to calculate Ka and Ks
             if (!(none + ng86 + lpb93 + lwl85 + mlwl85 + mlpb93 + gy94 + yn00 + myn06 + ms06 + ma06)) {
@@ -391,146 +918,155 @@ bool KAKS::parseParameter(int argc, const char* argv[]) {
 }
 
 /*******************************************************
- * Function: Calculate
- * Input Parameter: void
- * Output: Calculate kaks and output results.
- * Return Value: void
+ * Function: calculateKaKs
+ * Input Parameter: KaKsPair
+ * Output: Calculate kaks and keep results in the pair.
+ * Return Value: True if succeed, otherwise false.
  *
- * Note: 
+ * Note: Called by the threads in parallel, so only the pair
+ *       and its context are modified. The methods share the
+ *       stages of the pair: the codon pairs (NG, LWL, YN
+ *       methods), the sites and differences of NONE and NG,
+ *       the sums of LWL and LPB and of MLWL and MLPB, the
+ *       frequencies of YN and MYN, and the fit of GY under
+ *       HKY for MS. Each stage is computed by the first method
+ *       needing it in the order below.
  ********************************************************/
-bool KAKS::calculateKaKs() {
+bool KAKS::calculateKaKs(KaKsPair &pair) {
 
     bool flag = true;
+    SharedStages stages(pair.seq1, pair.seq2);
 
     try {
+        //Context of the pair, sharing the genetic code
+        pair.ctx = ctx;
+        pair.ctx.seq_name = pair.name;
+        pair.ctx.length = pair.seq1.length();
+        if (binary) pair.ctx.rows = &pair.rows;
+        pair.ctx.stages = &stages;
 
 		//Get GCC at three codon positions
-		getGCContent(seq1 + seq2);
+		getGCContent(pair.seq1 + pair.seq2, pair.ctx.GC);
 
         //Estimate Ka and Ks
-        if (none) start_NONE();
-        if (ng86) start_NG86();
-        if (lwl85) start_LWL85();
-        if (mlwl85) start_MLWL85();
-        if (lpb93) start_LPB93();
-        if (mlpb93) start_MLPB93();
-        if (gy94) start_GY94();
-        if (yn00) start_YN00();
-        if (myn06) start_MYN();
-        if (ms06 || ma06) start_MSMA();
-        
-		//add a lock "isOK4Win" to avoid the program collapse 
-		isOK4Win = false;
-        result4Win += result;
-		isOK4Win = true;
-
-        //Write into the file
-        if (output_filename.length() > 0 && os.is_open()) {
-            os << result;
-            os.flush();
-        }
-        result = "";
+        if (none) start_NONE(pair);
+        if (ng86) start_NG86(pair);
+        if (lwl85) start_LWL85(pair);
+        if (mlwl85) start_MLWL85(pair);
+        if (lpb93) start_LPB93(pair);
+        if (mlpb93) start_MLPB93(pair);
+        if (gy94) start_GY94(pair);
+        if (yn00) start_YN00(pair);
+        if (myn06) start_MYN(pair);
+        if (ms06 || ma06) start_MSMA(pair);
     } catch (...) {
         flag = false;
     }
+    pair.ctx.stages = NULL;
 
     return flag;
 }
 
 //NONE: NG without correction for multiple substitution
 
-void KAKS::start_NONE() {
+void KAKS::start_NONE(KaKsPair &pair) {
 
-    NONE zz;
-    result += zz.Run(seq1, seq2);
+    NONE zz(pair.ctx);
+    pair.result += zz.Run(pair.seq1, pair.seq2);
 }
 
 //NG
 
-void KAKS::start_NG86() {
+void KAKS::start_NG86(KaKsPair &pair) {
 
-    NG86 zz;
-    result += zz.Run(seq1, seq2);
+    NG86 zz(pair.ctx);
+    pair.result += zz.Run(pair.seq1, pair.seq2);
 }
 
 //LWL
 
-void KAKS::start_LWL85() {
+void KAKS::start_LWL85(KaKsPair &pair) {
 
-    LWL85 zz;
-    result += zz.Run(seq1, seq2);
+    LWL85 zz(pair.ctx);
+    pair.result += zz.Run(pair.seq1, pair.seq2);
 }
 
 //MLWL
 
-void KAKS::start_MLWL85() {
+void KAKS::start_MLWL85(KaKsPair &pair) {
 
-    MLWL85 zz;
-    result += zz.Run(seq1, seq2);
+    MLWL85 zz(pair.ctx);
+    pair.result += zz.Run(pair.seq1, pair.seq2);
 }
 
 //LPB
 
-void KAKS::start_LPB93() {
+void KAKS::start_LPB93(KaKsPair &pair) {
 
-    LPB93 zz;
-    result += zz.Run(seq1, seq2);
+    LPB93 zz(pair.ctx);
+    pair.result += zz.Run(pair.seq1, pair.seq2);
 }
 
 //MLPB
 
-void KAKS::start_MLPB93() {
+void KAKS::start_MLPB93(KaKsPair &pair) {
 
-    MLPB93 zz;
-    result += zz.Run(seq1, seq2);
+    MLPB93 zz(pair.ctx);
+    pair.result += zz.Run(pair.seq1, pair.seq2);
 }
 
 //GY
 
-void KAKS::start_GY94() {
+void KAKS::start_GY94(KaKsPair &pair) {
+
+    GY94 zz(pair.ctx, "HKY");
+    pair.result += zz.Run(pair.seq1.c_str(), pair.seq2.c_str());
 
-    GY94 zz("HKY");
-    result += zz.Run(seq1.c_str(), seq2.c_str());
+    //HKY is a candidate model of MS, not fitted again
+    if ((ms06 || ma06) && pair.ctx.stages != NULL) {
+        zz.getMLResult(pair.ctx.stages->gy);
+        pair.ctx.stages->fitted = true;
+    }
 }
 
 //YN
 
-void KAKS::start_YN00() {
+void KAKS::start_YN00(KaKsPair &pair) {
 
-    YN00 zz;
-    result += zz.Run(seq1, seq2);
+    YN00 zz(pair.ctx);
+    pair.result += zz.Run(pair.seq1, pair.seq2);
 }
 
 //MYN
 
-void KAKS::start_MYN() {
+void KAKS::start_MYN(KaKsPair &pair) {
 
-    MYN zz;
-    result += zz.Run(seq1, seq2);
+    MYN zz(pair.ctx);
+    pair.result += zz.Run(pair.seq1, pair.seq2);
 }
 
 /************************************************
  * Function: start_MSMA
- * Input Parameter: void
+ * Input Parameter: KaKsPair
  * Output: Calculate Ka and Ks using the method of 
                   model selection or model averaging.
  * Return Value: void
  *************************************************/
-void KAKS::start_MSMA() {
+void KAKS::start_MSMA(KaKsPair &pair) {
 
     vector<MLResult> result4MA; //generated by MS and used by MA
 
     //Model Selection
-    MS zz1;
-    string tmp = zz1.Run(seq1.c_str(), seq2.c_str(), result4MA, details);
+    MS zz1(pair.ctx);
+    string tmp = zz1.Run(pair.seq1.c_str(), pair.seq2.c_str(), result4MA, pair.details);
     if (ms06) {
-        result += tmp;
+        pair.result += tmp;
     }
 
     //Model Averaging
     if (ma06) {
-        MA zz2;
-        result += zz2.Run(seq1.c_str(), seq2.c_str(), result4MA);
+        MA zz2(pair.ctx);
+        pair.result += zz2.Run(pair.seq1.c_str(), pair.seq2.c_str(), result4MA);
     }
 }
 
@@ -546,6 +1082,8 @@ void KAKS::showParaInfo() {
 	programInfo();
 
 	cout << "Input file: "<< seq_filename << endl;
+	if (pairs_filename != "") cout << "Pairs file: " << pairs_filename << endl;
+	if (maf_species != "") cout << "Pairs of species in MAF file: " << maf_species << endl;
 	
 	//Output file(s)
 	if (detail_filename.length() > 0) {
@@ -570,7 +1108,9 @@ void KAKS::showParaInfo() {
     if (ma06) cout << "MA" << " ";
 	cout << endl;
 
-	cout << "Genetic code: " << transl_table[2 * (genetic_code - 1) + 1] << endl;
+	cout << "Genetic code: " << transl_table[2 * (ctx.genetic_code - 1) + 1] << endl;
+	if (threads > 1) cout << "Threads: " << threads << endl;
+	if (shard != "" || records != "") cout << "Records: " << first_record + 1 << "-" << last_record << endl;
     cout << "Please wait while reading sequences and calculating..." << endl;
 }
 
@@ -595,6 +1135,15 @@ string KAKS::getTitleInfo() {
     return title;
 }
 
+string KAKS::getInputName() {
+
+	string input = seq_filename;
+	if (pairs_filename != "") input += " " + pairs_filename;
+	if (maf_species != "") input += " " + maf_species;
+
+	return input;
+}
+
 /***********************************
  * Function: programInfo
  * Input Parameter:
@@ -647,6 +1196,19 @@ void KAKS::helpInfo() {
     cout << "\t\t  ALL(including all above methods)" << endl;
 
     cout << "\t-d\tFile name for details about each candidate model when using the method of MS" << endl;
+    cout << "\t-t\tNumber of threads for calculating pairs in parallel, results are kept in the input order [int, default = 1]" << endl;
+    cout << "\t--shard\tCalculate only the i-th of N nearly equal parts of the records, e.g. 3/200 for a job array [string, i/N]" << endl;
+    cout << "\t--records\tCalculate only the records from a to b, counted from 1 [string, a-b]" << endl;
+    cout << "\t\t  (Both seek by the index '<input file>" << AXTINDEX_SUFFIX << "' saved by " << AXTINDEX_NAME << ", or else scan the file first)" << endl;
+    cout << "\t--pairs\tList of pairs, two names of sequences on each line, with codon-aligned FASTA file as the input file [string]" << endl;
+    cout << "\t--maf\tCalculate the pairs of two species, or all pairs, in each block of MAF file as the input file [string, species1,species2 or ALL]" << endl;
+    cout << "\t--serve-work\tServe the pairs to workers connecting on the port, and write their results [int, port]" << endl;
+    cout << "\t--worker\tCalculate pairs served by a coordinator, with its methods and genetic code [string, host:port]" << endl;
+    cout << "\t--checkpoint\tSave the progress into '<output file>" << CHECKPOINT_SUFFIX << "' every given seconds [int]" << endl;
+    cout << "\t--resume\tContinue an interrupted run from its checkpoint, saving checkpoints every 60 seconds by default" << endl;
+    cout << "\t--flush-interval\tSeconds between writes of the output buffered in memory, 0 for writing each pair at once [int, default = " << WRITER_INTERVAL << "]" << endl;
+    cout << "\t--bgzf\tWrite the output and details compressed as BGZF, with an index '<file>" << BGZFINDEX_SUFFIX << "' of the pairs for KaKsExtract" << endl;
+    cout << "\t--binary\tWrite the output as binary columns of values, converted back into text by KaKsView" << endl;
 	cout << "\t-h\tHelp information" << endl; 
 	cout << endl;
 
@@ -654,6 +1216,15 @@ void KAKS::helpInfo() {
     cout << "\t" << KAKS_NAME << " -i test.axt -o test.axt.kaks\t//use MA method based on a more suitable model and standard code" << endl;
     cout << "\t" << KAKS_NAME << " -i test.axt -o test.axt.kaks -c 2\t//use MA method and vertebrate mitochondrial code" << endl;
     cout << "\t" << KAKS_NAME << " -i test.axt -o test.axt.kaks -m LWL -m MYN\t//use LWL and MYN methods, and standard Code" << endl;
+    cout << "\t" << KAKS_NAME << " -i test.axt -o test.axt.kaks -t 8\t//use MA method with 8 threads" << endl;
+    cout << "\t" << KAKS_NAME << " -i test.axt -o test.axt.kaks.3 --shard 3/200\t//use MA method on the 3rd of 200 parts" << endl;
+    cout << "\t" << KAKS_NAME << " -i genes.fa --pairs pairs.txt -o pairs.kaks\t//use MA method on the pairs listed by names in FASTA file" << endl;
+    cout << "\t" << KAKS_NAME << " -i cds.maf -o cds.maf.kaks --maf hg38,mm10\t//use MA method on human and mouse in each block of MAF file" << endl;
+    cout << "\t" << KAKS_NAME << " -i test.axt -o test.axt.kaks --serve-work 7000\t//serve pairs to workers like the one below" << endl;
+    cout << "\t" << KAKS_NAME << " --worker node1:7000 -t 8\t//calculate pairs served on node1 with 8 threads" << endl;
+    cout << "\t" << KAKS_NAME << " -i test.axt -o test.axt.kaks --checkpoint 600 --resume\t//continue where a run stopped" << endl;
+    cout << "\t" << KAKS_NAME << " -i test.axt -o test.axt.kaks.gz -m ALL --bgzf\t//write compressed output, then 'KaKsExtract test.axt.kaks.gz 5-8'" << endl;
+    cout << "\t" << KAKS_NAME << " -i test.axt -o test.axt.kaks.bin -m ALL --binary\t//write binary output, then 'KaKsView test.axt.kaks.bin'" << endl;
 
     cout << endl;
 
@@ -17,6 +17,16 @@
 #define  KAKS_H
 
 #include "base.h"
+#include "Parallel.h"
+#include "AXTIndex.h"
+#include "AXTReader.h"
+#include "PairReader.h"
+#include "MAFReader.h"
+#include "Cluster.h"
+#include "Checkpoint.h"
+#include "BGZF.h"
+#include "Columnar.h"
+#include "AsyncWriter.h"
 #include "NG86.h"
 #include "LWL85.h"
 #include "LPB93.h"
@@ -27,6 +37,70 @@
 
 using namespace std;
 
+/* A pair of sequences and its results, calculated independently of other pairs */
+struct KaKsPair {
+	/* Serial number among valid pairs, given when writing */
+	unsigned long id;
+	/* Pairwise sequences' name */
+	string name;
+	/* Sequences as read from file, the halves of the lines: views into
+	   the file, or into 'str' if not two lines of equal length or the
+	   file is compressed */
+	string_view half1, half2;
+	string str;
+	/* Total length of the sequences, freed with them after checking */
+	unsigned long length;
+	/* Byte offset of input file after the record */
+	long long end;
+	/* A pair of sequence, after deleting gaps and stop codons */
+	string seq1, seq2;
+	/* Context for calculating the pair */
+	Context ctx;
+	/* Error message when the pair is not valid */
+	string msg;
+	/* Results for writing into file, and details for model selection */
+	string result, details;
+	/* Results kept as values with --binary, in place of 'result' */
+	vector<ResultRow> rows;
+	/* Valid or not, calculated successfully or not, finished or not */
+	bool valid, ok, done;
+
+	KaKsPair(): id(0), length(0), end(0), valid(false), ok(false), done(false) {}
+
+	/* Take the sequences of a record, copying them only if not two lines of equal length
+	   or not kept by the reader */
+	void setRecord(const AXTRecord &rec) {
+		if (rec.kept && rec.lines.size() == 2 && rec.lines[0].length() == rec.lines[1].length()) {
+			half1 = rec.lines[0];
+			half2 = rec.lines[1];
+			length = rec.length;
+		}
+		else {
+			rec.join(str);
+			setString();
+		}
+	}
+
+	/* Take the sequences joined in 'str' */
+	void setString() {
+		string_view s(str);
+		length = str.length();
+		half1 = s.substr(0, length / 2);
+		half2 = s.substr(length / 2, length / 2);
+	}
+
+	/* Get the sequences joined, as in the file */
+	string getString() {
+		return str.length() == length ? str : string(half1) + string(half2);
+	}
+
+	/* Free the sequences */
+	void clearSequences() {
+		half1 = half2 = string_view();
+		str = "";
+	}
+};
+
 /* KAKS class */
 class KAKS: public Base {
 	
@@ -38,9 +112,13 @@ public:
 	bool Run(int argc, const char* argv[]);		
 	/* Read and Calculate seq, called in "Run" main function */
 	bool ReadCalculateSeq(string filename);
+	/* Calculate the pairs sent by a coordinator, called in "Run" main function */
+	bool RunWorker(string address);
 	
-	/* Get the result for Windows, depending on the bool isOK4Win */
+	/* Get the result for Windows, depending on the bool isOK4Win, kept after 'keepResult4Win' */
 	string getResult4Win();
+	/* Keep the rows written in 'result4Win', as the Windows version shows them */
+	void keepResult4Win();
 
 	/* Initialize class, ready for running */
 	int Initialize();
@@ -49,43 +127,58 @@ public:
 
 protected:		
 	/* Use several methods to calculate ka/ks */
-	bool calculateKaKs();
+	bool calculateKaKs(KaKsPair &pair);
+	/* Estimate the cost of calculating a pair for scheduling */
+	double estimateCost(unsigned long len);
+	/* Write the results of a pair into file, called by the writer in the input order */
+	bool writeResult(KaKsPair &pair);
+	/* Configuration sent to workers, and set by a worker */
+	vector<string> getWorkConf();
+	bool setWorkConf(const vector<string> &conf);
+	/* Save the progress after the records written, ending at the offset of input file */
+	bool saveCheckpoint(unsigned long done, long long offset);
+	/* Restore the progress of an interrupted run, giving the records done and their end */
+	bool restoreCheckpoint(unsigned long &done, long long &offset);
+	/* Open the details for model selection, as BGZF with --bgzf, and write the title */
+	bool openDetails(bool append);
 	/* Show help information */
 	void helpInfo();
 	/* Show help information */
 	void programInfo();
 
 	/* NONE: an in-house algorithm in BIG, that is NG86 without correction */
-	void start_NONE();
+	void start_NONE(KaKsPair &pair);
 	/* NG86 */
-	void start_NG86();
+	void start_NG86(KaKsPair &pair);
 	/* LWL85 */
-	void start_LWL85();
+	void start_LWL85(KaKsPair &pair);
 	/* Modified LWL85 */
-	void start_MLWL85();
+	void start_MLWL85(KaKsPair &pair);
 	/* LPB93 */
-	void start_LPB93();
+	void start_LPB93(KaKsPair &pair);
 	/* Modified LPB93 */
-	void start_MLPB93();
+	void start_MLPB93(KaKsPair &pair);
 	/* GY94 */
-	void start_GY94();	
+	void start_GY94(KaKsPair &pair);	
 	/* YN00 */
-	void start_YN00();
+	void start_YN00(KaKsPair &pair);
 	/* MYN */
-	void start_MYN();	
+	void start_MYN(KaKsPair &pair);	
 	/* Model Selection and Model Averaging */
-	void start_MSMA();
+	void start_MSMA(KaKsPair &pair);
 	
 
 
 	/* Check the sequence whether is valid or not */
-	bool checkValid(string name, string str);
+	bool checkValid(KaKsPair &pair);
 	/* Parse the input parameters */
 	bool parseParameter(int argc, const char* argv[]);
 	/* Show input parameters' information on screen */
 	void showParaInfo();
 	/* Get title information for writing into file */
 	string getTitleInfo();
+	/* Input files and selection, identifying the input of a checkpoint */
+	string getInputName();
 
 public:
 	/* Methods' name and reference */
@@ -99,14 +192,40 @@ public:
 	string result4Win;
 	/* Flag for outputing in Windows */
 	bool isOK4Win;
+	/* Receiver of the rows of each pair as written, none by default so that no rows are kept */
+	function<void(const string &rows)> result_sink;
 	
 	/* File name for output */
 	string output_filename;
 	/* Sequence file name */
 	string seq_filename;
+	/* List of pairs named in FASTA file given by '-i', empty for axt file */
+	string pairs_filename;
+	/* Species "species1,species2" or "ALL" paired in blocks of MAF file given by '-i', empty for axt file */
+	string maf_species;
 
 	/* Flag for whether to run NG86, MLWL85, MLPB93, GY94, YN00, MYN, MS/A=model selection/averaging */
 	bool none, ng86, lwl85, lpb93, yn00, mlwl85, mlpb93, gy94, myn06, ms06, ma06;	
+	/* Number of threads for calculating pairs in parallel */
+	int threads;
+	/* Records selected by "--shard i/N" or "--records a-b", all if both empty */
+	string shard, records;
+	/* Selected records from first to last (excluded), counted from 0 */
+	unsigned long first_record, last_record;
+	/* Port for serving pairs to workers, 0 if calculating here */
+	int serve_port;
+	/* Address "host:port" of the coordinator when running as a worker */
+	string worker_address;
+	/* Seconds between checkpoints, -1 for none */
+	int checkpoint_interval;
+	/* Seconds between writes of buffered output */
+	int flush_interval;
+	/* Continue from the checkpoint of an interrupted run */
+	bool resume;
+	/* Write the output and details as BGZF with an index of the pairs */
+	bool bgzf;
+	/* Write the output as binary columns, read by KaKsView */
+	bool binary;
 	/* Number of compared pairwise sequences */
 	unsigned long number;	//Maybe too many
 	/* Running time:  */
@@ -115,16 +234,25 @@ public:
 protected:
 	/* File name for detailed results for model selection */
 	string detail_filename;
-	/* Detailed results */
-	string details; 
+	/* Streams of detailed results, written as the pairs */
+	AsyncWriter dos;
+	BGZFWriter zds;
+	/* Bytes written into details file */
+	long long detail_length;
 	
 private:
 	/* The temporary results for write into file */
 	string result;
-	/* Output stream */
-	ofstream os;
-	/* A pair of sequence */
-	string seq1, seq2;
+	/* Output stream, written by its own thread */
+	AsyncWriter os;
+	/* Output stream with --bgzf */
+	BGZFWriter zos;
+	/* Output stream with --binary */
+	ColumnWriter cos;
+	/* Bytes written into output file */
+	long long output_length;
+	/* Progress of the run */
+	Checkpoint checkpoint;
 }; 
 
 #endif
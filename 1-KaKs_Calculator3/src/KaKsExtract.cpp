@@ -0,0 +1,85 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: KaKsExtract.cpp
+* Abstract: Extract the rows of some pairs from the BGZF output
+			or details of KaKs with '--bgzf', by the index of
+			the file, decompressing only the blocks needed.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+
+#include "BGZF.h"
+#include<stdio.h>
+
+#define KAKSEXTRACT_NAME "KaKsExtract"
+
+int main(int argc, const char* argv[]) {
+
+	try {
+		if (argc < 3) {
+			cout << "Usage: " << KAKSEXTRACT_NAME << " <BGZF file> <records a-b, record a or name> ...\t//records counted from 1" << endl;
+			cout << "Example:" << endl;
+			cout << "\t" << "KaKs -i test.axt -o test.axt.kaks.gz -m ALL --bgzf\t//write output with an index test.axt.kaks.gz" << BGZFINDEX_SUFFIX << endl;
+			cout << "\t" << KAKSEXTRACT_NAME << " test.axt.kaks.gz 5-8 AK1&AK2\t//then extract the rows of pairs 5 to 8 and of AK1&AK2" << endl;
+			throw 1;
+		}
+
+		string filename = argv[1];
+		BGZFIndex index;
+		if (!index.load(BGZFIndex::getIndexName(filename))) {
+			cout << "Error in reading index file " << BGZFIndex::getIndexName(filename) << "..." << endl;
+			throw 1;
+		}
+		ifstream is(filename.c_str(), ios::binary);
+		if (!is) {
+			cout << "Error in opening file..." << endl;
+			throw 1;
+		}
+
+		vector<long long> &starts = index.record_starts;
+		unsigned long n = starts.size(), i, a, b;
+		string content;
+
+		//Title before the first pair
+		if (!index.readRange(is, 0, n > 0 ? starts[0] : index.length, content)) throw 1;
+		cout << content;
+
+		for (int k = 2; k < argc; k++) {
+			string arg = argv[k];
+			char c;
+
+			//Pairs [a, b) counted from 0
+			vector< pair<unsigned long, unsigned long> > ranges;
+			if (sscanf(arg.c_str(), "%lu-%lu%c", &a, &b, &c) == 2 && a >= 1 && a <= b) {
+				ranges.push_back(make_pair(a - 1, b < n ? b : n));
+			}
+			else if (sscanf(arg.c_str(), "%lu%c", &a, &c) == 1 && a >= 1) {
+				ranges.push_back(make_pair(a - 1, a < n ? a : n));
+			}
+			else {
+				for (i = 0; i < n; i++) {
+					if (index.record_names[i] == arg) ranges.push_back(make_pair(i, i + 1));
+				}
+			}
+
+			for (i = 0; i < ranges.size(); i++) {
+				if (ranges[i].first >= ranges[i].second) continue;
+				long long start = starts[ranges[i].first];
+				long long end = ranges[i].second < n ? starts[ranges[i].second] : index.length;
+				if (!index.readRange(is, start, end, content)) {
+					cout << "Error in reading file..." << endl;
+					throw 1;
+				}
+				cout << content;
+			}
+		}
+	}
+	catch (...) {
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,55 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: KaKsView.cpp
+* Abstract: Convert the binary columnar output of KaKs with
+			'--binary' back into the rows of text, as written
+			by KaKs without it.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+
+#include "Columnar.h"
+
+#define KAKSVIEW_NAME "KaKsView"
+
+int main(int argc, const char* argv[]) {
+
+	try {
+		if (argc != 2) {
+			cout << "Usage: " << KAKSVIEW_NAME << " <binary file>\t//print the rows as text" << endl;
+			cout << "Example:" << endl;
+			cout << "\t" << "KaKs -i test.axt -o test.axt.kaks.bin -m ALL --binary\t//write binary output" << endl;
+			cout << "\t" << KAKSVIEW_NAME << " test.axt.kaks.bin > test.axt.kaks\t//then convert it into text" << endl;
+			throw 1;
+		}
+
+		ColumnReader reader;
+		if (!reader.open(argv[1])) {
+			cout << "Error in opening file..." << endl;
+			throw 1;
+		}
+
+		vector<ResultRow> rows;
+		string line;
+		cout << reader.title;
+		while (reader.next(rows)) {
+			for (unsigned long i = 0; i < rows.size(); i++) {
+				line = "";
+				Base::formatRow(rows[i], line);
+				cout << line;
+			}
+		}
+		if (reader.isFailed()) {
+			cerr << "Error in reading file..." << endl;
+			throw 1;
+		}
+	}
+	catch (...) {
+		return 1;
+	}
+
+	return 0;
+}
@@ -44,15 +44,25 @@ KNKS::~KNKS() {
 
 int KNKS::Initialize() {
 
-	GY94 tmp("HKY");
+	GY94 tmp(ctx, "HKY");
 	
 	zz = tmp;
 
-	result4Win = nc_result = coding_result = seq_name = seq1 = seq2 = "";
+	result4Win = nc_result = seq1 = seq2 = "";
 	input_nc_filename = input_coding_filename = output_nc_filename = output_coding_filename = "";
-	nc_result = coding_result = "";
-	genetic_code = 1;
+	nc_result = "";
+	ctx = Context();
 	number = 0;
+	threads = 1;
+	shard = records = "";
+	first_record = last_record = 0;
+	join_names = false;
+	join_filename = "";
+	checkpoint_interval = -1;
+	flush_interval = WRITER_INTERVAL;
+	resume = false;
+	output_length = coding_length = 0;
+	cds_runs = 0;
 
 	mutation_rate = NA;
 
@@ -67,6 +77,7 @@ int KNKS::Uninitialize() {
 	if (os.is_open()) {
 		os.close();
 	}
+	cds_os.close();
 	hh = mm = ss = 0;
 	return 1;
 }
@@ -78,59 +89,45 @@ string KNKS::getResult4Win() {
 	return "";
 }
 
-bool KNKS::checkValid(string name, string str) {
+void KNKS::keepResult4Win() {
+	result_sink = [this](const string &rows) {
+		//add a lock "isOK4Win" to avoid the program collapse
+		isOK4Win = false;
+		result4Win += rows;
+		isOK4Win = true;
+	};
+}
+
+/**************************************************
+ * Function: checkValid
+ * Input Parameter: string, string, string, string
+ * Output: Check validity of pairwise coding sequences,
+ *         and delete gaps and stop codons
+ * Return Value: True if succeed, otherwise false.
+ ***************************************************/
+bool KNKS::checkValid(const string &str, string &seq1, string &seq2, string &msg) {
 	bool flag = true;
-	long i;
 
 	try {
 
 		//Check whether sequences are equal in length
 		if (str.length() % 2 != 0) {
-			cout << "[Error. The sequences are not equal in length.]";
+			msg = "[Error. The sequences are not equal in length.]";
 			throw 1;
 		}
 
-		string str1 = str.substr(0, str.length() / 2);
-		string str2 = str.substr(str.length() / 2, str.length() / 2);
+		string_view s(str);
+		string_view str1 = s.substr(0, str.length() / 2);
+		string_view str2 = s.substr(str.length() / 2, str.length() / 2);
 
 		//Check whether (sequence length)/3==0
 		if (str1.length() % 3 != 0 || str2.length() % 3 != 0) {
-			cout << "[Error. The sequences are not codon-based alignment.]";
+			msg = "[Error. The sequences are not codon-based alignment.]";
 			throw 1;
 		}
 
 		//Delete gap and stop codon
-		bool found;
-		int j;
-		for (i = 0; i < str1.length(); i += 3) {
-			for (found = false, j = 0; j < 3 && !found; j++) {
-				if (str1[j + i] == '-' || str2[j + i] == '-') {
-					found = true;
-				}
-				str1[i + j] = toupper(str1[i + j]);
-				str2[i + j] = toupper(str2[i + j]);
-				if (convertChar(str1[i + j]) == -1 || convertChar(str2[i + j]) == -1) {
-					found = true;
-				}
-			}
-
-			if ((getAminoAcid(str1.substr(i, 3)) == '!') || (getAminoAcid(str2.substr(i, 3)) == '!')) {
-				found = true;
-			}
-
-			if (found) {
-				str1 = str1.replace(i, 3, "");
-				str2 = str2.replace(i, 3, "");
-				i -= 3;
-			}
-		}
-
-		//pass value into private variables
-		seq1 = str1;
-		seq2 = str2;
-		//pass value into extern variables
-		seq_name = name;
-		length = str1.length();
+		filterCodons(str1, str2, seq1, seq2);
 	}
 	catch (...) {
 		flag = false;
@@ -146,7 +143,13 @@ bool KNKS::checkValid(string name, string str) {
 				  and calculate Ka and Ks.
  * Return Value: True if succeed, otherwise false.
 
- * Note: Using axt file for low memory
+ * Note: Using axt file for low memory. With --shard or
+ *       --records, the selected records of both files are
+ *       read from their offsets by the index of axt file.
+ *       With --resume, so are the records after those done
+ *       before the checkpoint. Pairing coding records by
+ *       order, the numbers of records are compared by the
+ *       indexes before calculating.
  *****************************************************/
 bool KNKS::ReadCalculateSeq(string filename) {
 
@@ -156,130 +159,184 @@ bool KNKS::ReadCalculateSeq(string filename) {
 	bool flag = true;
 
 	try {
+		nc_result = getNCTitleInfo();
+
+		//Continue after the records done, or start from the first one
+		unsigned long done = 0;
+		bool resumed = resume && checkpoint.load(output_nc_filename + CHECKPOINT_SUFFIX);
+		if (resumed) {
+			if (!restoreCheckpoint(done)) throw 1;
+		}
+		else if (resume) {
+			cout << "No checkpoint found, starting from the first record..." << endl;
+		}
+
+		//Offsets of the selected records
+		long long nc_start = 0, coding_start = 0;
+		unsigned long count = (unsigned long)-1;
+		bool join = (join_names || join_filename != "");
+		bool ordered = (mutation_rate == NA && !join);
+		if (shard != "" || records != "" || done > 0 || ordered) {
+			AXTIndex nc_index, coding_index;
+			if (!nc_index.load(input_nc_filename) || !nc_index.select(shard, records, first_record, last_record)) {
+				throw 1;
+			}
+			first_record = first_record + done < last_record ? first_record + done : last_record;
+			count = last_record - first_record;
+			if (first_record < nc_index.offsets.size()) nc_start = nc_index.offsets[first_record];
+
+			//Coding records in the same order, as many as noncoding ones, unless found by name
+			if (ordered) {
+				if (!coding_index.load(input_coding_filename)) throw 1;
+				if (coding_index.offsets.size() != nc_index.offsets.size()) {
+					cout << "Error. The coding file has " << (coding_index.offsets.size() < nc_index.offsets.size() ? "fewer" : "more");
+					cout << " records than the noncoding file; pair them by name with --join-names or --join-map." << endl;
+					throw 1;
+				}
+				if (first_record < coding_index.offsets.size()) coding_start = coding_index.offsets[first_record];
+			}
+		}
+
 		showParaInfo();	//Show information on display
 
-		vector<string> vec_nc_names, vec_nc_seqs;
-		//Read noncoding sequences
-		if (!readAXTSeq(input_nc_filename, vec_nc_names, vec_nc_seqs)) {
+		//Both files are read record by record, only the pairs in the window are kept
+		AXTReader nc, cds;
+		if (!nc.open(input_nc_filename)) {
+			cout << "Error in opening file..." << endl;
 			throw 1;
 		}
+		if (nc_start > 0) nc.seek(nc_start);
 
-		vector<string> vec_coding_names, vec_coding_seqs;
 		//mutation_rate is provided by user
 		if (mutation_rate!=NA) {
 			Ks = mutation_rate;
 		}
 		else {//mutation rate needs to be inferred from adjacent coding sequences
-			if (!readAXTSeq(input_coding_filename, vec_coding_names, vec_coding_seqs) ||
-				vec_nc_names.size() != vec_coding_names.size()) {
+			if (!cds.open(input_coding_filename)) {
+				cout << "Error in opening file..." << endl;
 				throw 1;
 			}
+			if (join && !loadJoin(cds)) throw 1;
+			if (coding_start > 0) cds.seek(coding_start);
 		}
 
-		//Output stream
+		//Output stream, appended to the part written before the checkpoint
 		if (output_nc_filename!= "" && output_nc_filename.length() > 0) {
-			os.open(output_nc_filename.c_str());
+			os.open(output_nc_filename, resumed, flush_interval);
 		}
 
-		nc_result = getNCTitleInfo();
-		coding_result = getCDSTitleInfo();
-
-		string temp = "";
-		for (int i = 0; i < vec_nc_seqs.size(); i++) {
-			//Check str's validility and calculate
-			cout << "[" << i + 1 << "] " << vec_nc_names[i] << "\t";
-			if (checkNCValid(vec_nc_names[i], vec_nc_seqs[i])) {
-				try {
-
-					//Noncoding sequences: Kn 
-					calculateKnKs(seq1, seq2);
-					//cout << Kn;
-					//cout << "[Noncoding Kn]" << "\t";
-					
-					if (mutation_rate!=NA) {//Ks is provided by user
-						/*"Sequence", "Kn", "Ks", "Kn/Ks", "Length", "Substitutions", "Kappa", "GC" */
-						addString(nc_result, vec_nc_names[i]);
-						addString(nc_result, CONVERT<string>(Kn));
-						addString(nc_result, CONVERT<string>(Ks));
-						if (Ks < SMALLVALUE || Ks == NA || Kn == NA) {
-							addString(nc_result, "NA");
-						}
-						else {
-							addString(nc_result, CONVERT<string>(Kn / Ks));
-						}
-						addString(nc_result, CONVERT<string>(nc_len));
-						addString(nc_result, CONVERT<string>(nc_ts + nc_tv));
-						addString(nc_result, CONVERT<string>(nc_kappa));
-						addString(nc_result, CONVERT<string>(nc_GC));
-
-						//CDS items
-						addString(nc_result, "NA");
-						addString(nc_result, "NA");
-						addString(nc_result, "NA");
-						addString(nc_result, "NA");
-						addString(nc_result, "NA");
-						addString(nc_result, "NA");
-						addString(nc_result, "NA", "\n");
+		//Coding results, written as the pairs after their title
+		if (output_coding_filename != "") {
+			if (!cds_os.open(output_coding_filename, resumed && coding_length > 0, flush_interval)) {
+				cout << "Error in writing to file..." << endl;
+				throw 1;
+			}
+			if (coding_length == 0) {
+				string title = getCDSTitleInfo();
+				cds_os.write(title);
+				coding_length = title.length();
+			}
+		}
+
+		//Pairs being calculated or waiting for writing, in the input order
+		deque<KnKsPair*> window;
+		size_t limit = 16 * threads;
+		mutex lock;
+		condition_variable finished;
+		TaskGroup group;
+
+		//Write the finished pairs at the head of window, or wait for the head if 'all' or window is full
+		auto writeReady = [&](bool all) {
+			while (!window.empty()) {
+				{
+					unique_lock<mutex> lk(lock);
+					if (!window.front()->done && !all && window.size() < limit) break;
+					while (!window.front()->done) finished.wait(lk);
+				}
+				KnKsPair *pair = window.front();
+				window.pop_front();
+				writeResult(*pair);
+				if (pair->cds_valid) cds_runs = pair->runs + 1;
+				if (checkpoint.isDue(checkpoint_interval)) saveCheckpoint(done + pair->index + 1);
+				delete pair;
+			}
+		};
+
+		//Coding pairs calculated, as they were by one GY94 object in turn
+		unsigned long runs = cds_runs;
+
+		try {
+			AXTRecord rec, cds_rec;
+			string cds_str;
+			for (unsigned long i = 0; i < count && nc.next(rec); i++) {
+				KnKsPair *pair = new KnKsPair();
+				pair->index = i;
+				pair->name = string(rec.name);
+				rec.join(pair->str);
+				window.push_back(pair);
+
+				//The adjacent coding pair: the next one, or the one of the name
+				bool found = false;
+				if (ordered) {
+					//Changed since indexed: the pairs before are written whatever the threads
+					if (!cds.next(cds_rec)) {
+						cout << "Error. The coding file has fewer records than the noncoding file; pair them by name with --join-names or --join-map." << endl;
+						window.pop_back();
+						delete pair;
+						writeReady(true);
+						throw 1;
 					}
-					else {//Ks is inferred from input CDS 
-						if (checkValid(vec_coding_names[i], vec_coding_seqs[i])) {
-							getGCContent(seq1 + seq2); 
-							coding_result += zz.Run(seq1.c_str(), seq2.c_str());
-							Ks = zz.Ks;
-						}
-						/*"Sequence", "Kn", "Ks", "Kn/Ks", "Length", "Substitutions", "Kappa", "GC" */
-						addString(nc_result, vec_nc_names[i]);
-						addString(nc_result, CONVERT<string>(Kn));
-						addString(nc_result, CONVERT<string>(Ks));
-						if (Ks < SMALLVALUE || Ks == NA || Kn == NA) {
-							addString(nc_result, "NA");
-						}
-						else {
-							addString(nc_result, CONVERT<string>(Kn / Ks));
-						}
-						addString(nc_result, CONVERT<string>(nc_len));
-						addString(nc_result, CONVERT<string>(nc_ts + nc_tv));
-						addString(nc_result, CONVERT<string>(nc_kappa));
-						addString(nc_result, CONVERT<string>(nc_GC));
-
-						/* "CDS", "Ka", "Ka/Ks", "CDS-Length", "CDS-Substitutions", "CDS-Kappa", "GC(1:2:3)" */
-						addString(nc_result, vec_coding_names[i]);
-						addString(nc_result, CONVERT<string>(zz.Ka));
-						addString(nc_result, CONVERT<string>(zz.Ka / zz.Ks));
-						addString(nc_result, CONVERT<string>(seq1.length()));
-						addString(nc_result, CONVERT<string>(zz.snp));
-						addString(nc_result, CONVERT<string>(zz.KAPPA[0]));
-						//GC Content
-						string tmp = "";
-						tmp = CONVERT<string>(GC[0]);	tmp += "(";
-						tmp += CONVERT<string>(GC[1]);	tmp += ":";
-						tmp += CONVERT<string>(GC[2]);	tmp += ":";
-						tmp += CONVERT<string>(GC[3]);	tmp += ")";
-						addString(nc_result, tmp, "\n");
+					found = true;
+				}
+				else if (mutation_rate == NA) {
+					if (join_names) {
+						pair->cds_name = pair->name;
 					}
-					
-					cout << "[OK]";
-					number++;
-					//cout << nc_result;
-
-					//add a lock "isOK4Win" to avoid the program collapse 
-					isOK4Win = false;
-					result4Win += nc_result;
-					isOK4Win = true;
-
-					//Write into the file
-					if (output_nc_filename.length() > 0 && os.is_open()) {
-						os<<nc_result.c_str();
-						os.flush();
+					else {
+						unordered_map<string, string>::iterator it = join_map.find(pair->name);
+						pair->cds_name = it != join_map.end() ? it->second : "NA";
 					}
-					nc_result = "";
+					unordered_map<string, long long>::iterator it = coding_offsets.find(pair->cds_name);
+					if (it != coding_offsets.end()) {
+						cds.seek(it->second);
+						found = cds.next(cds_rec);
+					}
+					if (!found) pair->cds_msg = "[Error. No coding sequences paired with " + pair->name + ".]";
+				}
+				if (found) {
+					pair->cds_name = string(cds_rec.name);
+					cds_rec.join(cds_str);
+				}
 
-				}catch(...) {
-					cout << "[Error in calculating]";
+				//Coding sequences: Ks by GY, in parallel
+				if (found && pair->str.length() % 2 == 0 &&
+					(pair->cds_valid = checkValid(cds_str, pair->seq1, pair->seq2, pair->cds_msg))) {
+					pair->runs = runs++;
+					group.run([this, pair, &lock, &finished]() {
+						calculateCDS(*pair);
+						lock_guard<mutex> lk(lock);
+						pair->done = true;
+						finished.notify_all();
+					}, pair->seq1.length());
+				}
+				else {
+					pair->done = true;
 				}
-			}//end of if
-			cout << endl;
-		}//end of for
+
+				writeReady(false);
+			}
+			writeReady(true);
+			if (nc.isFailed() || cds.isFailed()) throw 1;
+		}
+		catch (...) {
+			//Let the running pairs finish before freeing them
+			group.wait();
+			while (!window.empty()) {
+				delete window.front();
+				window.pop_front();
+			}
+			throw;
+		}
 
 		cout << nc_result;
 
@@ -297,6 +354,297 @@ bool KNKS::ReadCalculateSeq(string filename) {
 	return flag;
 }
 
+/**************************************************
+ * Function: calculateCDS
+ * Input Parameter: KnKsPair
+ * Output: Calculate Ks of the adjacent coding pair by GY,
+ *         keeping the estimates in the pair.
+ * Return Value: void
+ *
+ * Note: Called by the threads in parallel, each with a GY94
+ *       object of its own, whose random numbers continue from
+ *       the coding pairs before.
+ ***************************************************/
+void KNKS::calculateCDS(KnKsPair &pair) {
+
+	try {
+		Context c = ctx;
+		c.seq_name = pair.cds_name;
+		c.length = pair.seq1.length();
+		getGCContent(pair.seq1 + pair.seq2, c.GC);
+
+		GY94 zz(c, "HKY");
+		zz.skipRuns(pair.runs);
+		pair.cds_result = zz.Run(pair.seq1.c_str(), pair.seq2.c_str());
+		pair.Ka = zz.Ka;
+		pair.Ks = zz.Ks;
+		pair.snp = zz.snp;
+		pair.kappa = zz.KAPPA[0];
+		pair.cds_len = pair.seq1.length();
+		copyArray(c.GC, pair.GC, 4);
+		pair.seq1 = pair.seq2 = "";
+	}
+	catch (...) {
+		pair.ok = false;
+	}
+}
+
+/**************************************************
+ * Function: saveCheckpoint
+ * Input Parameter: unsigned long
+ * Output: Save the records written, the lengths of outputs
+ *         and the estimates kept for the next records. The
+ *         details of coding estimates are written so far.
+ * Return Value: True if succeed, otherwise false.
+ ***************************************************/
+bool KNKS::saveCheckpoint(unsigned long done) {
+
+	checkpoint.set("program", KNKS_NAME);
+	checkpoint.set("input", input_nc_filename);
+	checkpoint.set("coding", mutation_rate == NA ? input_coding_filename : CONVERT<string>(mutation_rate));
+	checkpoint.setInteger("code", ctx.genetic_code);
+	checkpoint.set("selection", shard + records);
+	checkpoint.set("join", join_names ? "names" : join_filename);
+	checkpoint.setInteger("records", done);
+	checkpoint.setInteger("number", number);
+	if (os.is_open() && !os.flush()) return false;
+	checkpoint.setInteger("output", output_length);
+	if (cds_os.is_open() && !cds_os.flush()) return false;
+	checkpoint.setInteger("details", coding_length);
+	checkpoint.setInteger("runs", cds_runs);
+
+	//Estimates carried over to the next records
+	checkpoint.set("nc_GC", nc_GC);
+	checkpoint.set("Ks", Ks);
+	checkpoint.set("cds_Ka", zz.Ka);
+	checkpoint.set("cds_Ks", zz.Ks);
+	checkpoint.set("cds_snp", zz.snp);
+	checkpoint.set("cds_kappa", zz.KAPPA[0]);
+	for (int i = 0; i < 4; i++) checkpoint.set("GC" + CONVERT<string>(i), ctx.GC[i]);
+
+	return checkpoint.save(output_nc_filename + CHECKPOINT_SUFFIX);
+}
+
+/**************************************************
+ * Function: restoreCheckpoint
+ * Input Parameter: unsigned long
+ * Output: Check that the checkpoint is of the same run,
+ *         cut the outputs to their lengths at the checkpoint
+ *         and restore the estimates kept for the next records.
+ * Return Value: True if succeed, otherwise false.
+ ***************************************************/
+bool KNKS::restoreCheckpoint(unsigned long &done) {
+
+	bool flag = true;
+
+	try {
+		if (checkpoint.get("program") != KNKS_NAME || checkpoint.get("input") != input_nc_filename ||
+			checkpoint.get("coding") != (mutation_rate == NA ? input_coding_filename : CONVERT<string>(mutation_rate)) ||
+			checkpoint.getInteger("code") != ctx.genetic_code || checkpoint.get("selection") != shard + records ||
+			checkpoint.get("join") != (join_names ? "names" : join_filename)) {
+			cout << "Error. The checkpoint is of another run." << endl;
+			throw 1;
+		}
+
+		done = (unsigned long)checkpoint.getInteger("records");
+		number = (int)checkpoint.getInteger("number");
+		output_length = checkpoint.getInteger("output");
+		cds_runs = (unsigned long)checkpoint.getInteger("runs");
+
+		nc_GC = checkpoint.getNumber("nc_GC");
+		Ks = checkpoint.getNumber("Ks");
+		zz.Ka = checkpoint.getNumber("cds_Ka");
+		zz.Ks = checkpoint.getNumber("cds_Ks");
+		zz.snp = checkpoint.getNumber("cds_snp");
+		zz.KAPPA[0] = checkpoint.getNumber("cds_kappa");
+		for (int i = 0; i < 4; i++) ctx.GC[i] = checkpoint.getNumber("GC" + CONVERT<string>(i));
+
+		if (!Checkpoint::truncateFile(output_nc_filename, output_length) && output_length > 0) throw 1;
+		if (output_length > 0) nc_result = "";
+
+		coding_length = checkpoint.getInteger("details");
+		if (output_coding_filename != "" && !Checkpoint::truncateFile(output_coding_filename, coding_length) && coding_length > 0) {
+			throw 1;
+		}
+
+		cout << "Resuming after " << done << " records..." << endl;
+	}
+	catch (...) {
+		cout << "Error in resuming from checkpoint..." << endl;
+		flag = false;
+	}
+
+	return flag;
+}
+
+/**************************************************
+ * Function: loadJoin
+ * Input Parameter: AXTReader
+ * Output: Read the pairs of names from 'join_filename', and
+ *         scan coding file for the offset of each record by
+ *         its name, the first one of a name repeated.
+ * Return Value: True if succeed, otherwise false.
+ *
+ * Note: Only the names and offsets are kept, the coding
+ *       records are read again when their noncoding ones.
+ ***************************************************/
+bool KNKS::loadJoin(AXTReader &cds) {
+
+	bool flag = true;
+
+	try {
+		join_map.clear();
+		coding_offsets.clear();
+
+		if (join_filename != "") {
+			ifstream is(join_filename.c_str());
+			if (!is) {
+				cout << "Error in opening file " << join_filename << "..." << endl;
+				throw 1;
+			}
+			//"noncoding name<TAB>coding name" per line
+			string line;
+			while (getline(is, line)) {
+				if (line.length() > 0 && line[line.length() - 1] == '\r') line.erase(line.length() - 1);
+				size_t p = line.find('\t');
+				if (line.length() == 0 || line[0] == '#') continue;
+				if (p == string::npos) {
+					cout << "Error in reading file " << join_filename << ": " << line << endl;
+					throw 1;
+				}
+				join_map.emplace(line.substr(0, p), line.substr(p + 1));
+			}
+		}
+
+		AXTRecord rec;
+		long long start = 0;
+		while (cds.next(rec)) {
+			coding_offsets.emplace(string(rec.name), start);
+			start = rec.end;
+		}
+		if (cds.isFailed()) throw 1;
+	}
+	catch (...) {
+		flag = false;
+	}
+
+	return flag;
+}
+
+/**************************************************
+ * Function: writeResult
+ * Input Parameter: KnKsPair
+ * Output: Calculate Kn of the noncoding pair, and write
+ *         results into file in the input order.
+ * Return Value: void
+ *
+ * Note: Kn is cheap and calculated here one by one. The
+ *       estimates of the last valid coding pair are kept
+ *       for the noncoding pairs whose coding pair is not.
+ ***************************************************/
+void KNKS::writeResult(KnKsPair &pair) {
+
+	const string &name = pair.name;
+
+	//Check str's validility and calculate
+	cout << "[" << first_record + pair.index + 1 << "] " << name << "\t";
+	if (checkNCValid(name, pair.str)) {
+		try {
+			if (!pair.ok) throw 1;
+
+			//Noncoding sequences: Kn 
+			calculateKnKs(seq1, seq2);
+			
+			if (mutation_rate!=NA) {//Ks is provided by user
+				/*"Sequence", "Kn", "Ks", "Kn/Ks", "Length", "Substitutions", "Kappa", "GC" */
+				addString(nc_result, name);
+				addNumber(nc_result, Kn);
+				addNumber(nc_result, Ks);
+				if (Ks < SMALLVALUE || Ks == NA || Kn == NA) {
+					addString(nc_result, "NA");
+				}
+				else {
+					addNumber(nc_result, Kn / Ks);
+				}
+				addNumber(nc_result, nc_len);
+				addNumber(nc_result, nc_ts + nc_tv);
+				addNumber(nc_result, nc_kappa);
+				addNumber(nc_result, nc_GC);
+
+				//CDS items
+				addString(nc_result, "NA");
+				addString(nc_result, "NA");
+				addString(nc_result, "NA");
+				addString(nc_result, "NA");
+				addString(nc_result, "NA");
+				addString(nc_result, "NA");
+				addString(nc_result, "NA", "\n");
+			}
+			else {//Ks is inferred from input CDS 
+				unsigned long cds_len = seq1.length();
+				if (pair.cds_valid) {
+					if (cds_os.is_open()) {
+						cds_os.write(pair.cds_result);
+						coding_length += pair.cds_result.length();
+					}
+					Ks = zz.Ks = pair.Ks;
+					zz.Ka = pair.Ka;
+					zz.snp = pair.snp;
+					zz.KAPPA[0] = pair.kappa;
+					copyArray(pair.GC, ctx.GC, 4);
+					cds_len = pair.cds_len;
+				}
+				else {
+					cout << pair.cds_msg;
+				}
+				/*"Sequence", "Kn", "Ks", "Kn/Ks", "Length", "Substitutions", "Kappa", "GC" */
+				addString(nc_result, name);
+				addNumber(nc_result, Kn);
+				addNumber(nc_result, Ks);
+				if (Ks < SMALLVALUE || Ks == NA || Kn == NA) {
+					addString(nc_result, "NA");
+				}
+				else {
+					addNumber(nc_result, Kn / Ks);
+				}
+				addNumber(nc_result, nc_len);
+				addNumber(nc_result, nc_ts + nc_tv);
+				addNumber(nc_result, nc_kappa);
+				addNumber(nc_result, nc_GC);
+
+				/* "CDS", "Ka", "Ka/Ks", "CDS-Length", "CDS-Substitutions", "CDS-Kappa", "GC(1:2:3)" */
+				addString(nc_result, pair.cds_name);
+				addNumber(nc_result, zz.Ka);
+				addNumber(nc_result, zz.Ka / zz.Ks);
+				addNumber(nc_result, cds_len);
+				addNumber(nc_result, zz.snp);
+				addNumber(nc_result, zz.KAPPA[0]);
+				//GC Content
+				addNumber(nc_result, ctx.GC[0], "(");
+				addNumber(nc_result, ctx.GC[1], ":");
+				addNumber(nc_result, ctx.GC[2], ":");
+				addNumber(nc_result, ctx.GC[3], ")\n");
+			}
+			
+			cout << "[OK]";
+			number++;
+
+			if (result_sink) result_sink(nc_result);
+
+			//Write into the file
+			if (output_nc_filename.length() > 0 && os.is_open()) {
+				os.write(nc_result);
+				output_length += nc_result.length();
+			}
+			nc_result = "";
+
+		}catch(...) {
+			cout << "[Error in calculating]";
+		}
+	}//end of if
+	cout << endl;
+}
+
 /* Get corrected distance based on JC69 */
 double KNKS::getDistanceJC69(double p) {
 	double d = 1 - (4 * p) / 3;
@@ -370,9 +718,9 @@ bool KNKS::checkNCValid(string name, string str) {
 		seq1 = str.substr(0, str.length() / 2);
 		seq2 = str.substr(str.length() / 2, str.length() / 2);
 
-		//pass value into extern variables
-		seq_name = name;
-		length = seq1.length();
+		//pass value into the context
+		ctx.seq_name = name;
+		ctx.length = seq1.length();
 	}
 	catch (...) {
 		flag = false;
@@ -396,18 +744,28 @@ bool KNKS::Run(int argc, const char* argv[]) {
 			throw 1;
 		}
 
+		//Threads for calculating pairs
+		TaskGroup::setThreads(threads);
+
 		//Read sequences and calculate Kn & Ks
-		ReadCalculateSeq(input_nc_filename);
+		bool finished = ReadCalculateSeq(input_nc_filename);
 
 		//writeFile(output_nc_filename, nc_result.c_str());
 		//Output results
 		cout << "Outputing results: ";
 		cout << output_nc_filename;
+		if (!os.close()) finished = false;
 		//Output CDS details
-		if ( writeFile(output_coding_filename, coding_result.c_str()) == true) {
+		if (cds_os.close()) {
 			cout << "\t" << output_coding_filename;
 		}
 		cout << endl;
+		if (!finished) throw 1;
+
+		//A finished run needs no checkpoint
+		if (finished && checkpoint_interval >= 0) {
+			Checkpoint::remove(output_nc_filename + CHECKPOINT_SUFFIX);
+		}
 
 		//Print on display
 		cout << "Mission accomplished. (Time elapsed: ";
@@ -502,8 +860,8 @@ bool KNKS::parseParameter(int argc, const char* argv[]) {
 				}//Genetic Code Table
 				else if (temp == "-C") {
 					if ((i + 1) < argc && codeflag == 0) {
-						genetic_code = CONVERT<int>(argv[++i]);
-						if (genetic_code < 1 || genetic_code > NCODE || strlen(transl_table[2 * (genetic_code - 1)]) < 1)
+						ctx.genetic_code = CONVERT<int>(argv[++i]);
+						if (ctx.genetic_code < 1 || ctx.genetic_code > NCODE || strlen(transl_table[2 * (ctx.genetic_code - 1)]) < 1)
 							throw 1;
 						codeflag++;
 					}
@@ -515,6 +873,40 @@ bool KNKS::parseParameter(int argc, const char* argv[]) {
 					if ((i + 1) > argc) throw 1;
 					output_coding_filename = argv[++i];
 					output_coding_flag++;
+				}//Number of threads
+				else if (temp == "-T") {
+					if ((i + 1) >= argc) throw 1;
+					threads = CONVERT<int>(argv[++i]);
+					if (threads < 1) throw 1;
+				}//Records selected from the index of axt files
+				else if (temp == "--SHARD") {
+					if ((i + 1) >= argc || records != "") throw 1;
+					shard = argv[++i];
+				}
+				else if (temp == "--RECORDS") {
+					if ((i + 1) >= argc || shard != "") throw 1;
+					records = argv[++i];
+				}//Checkpoints of progress
+				else if (temp == "--CHECKPOINT") {
+					if ((i + 1) >= argc) throw 1;
+					checkpoint_interval = CONVERT<int>(argv[++i]);
+					if (checkpoint_interval < 0) throw 1;
+				}
+				else if (temp == "--RESUME") {
+					resume = true;
+				}//Coding pairs found by name
+				else if (temp == "--JOIN-NAMES") {
+					if (join_filename != "") throw 1;
+					join_names = true;
+				}
+				else if (temp == "--JOIN-MAP") {
+					if ((i + 1) >= argc || join_names) throw 1;
+					join_filename = argv[++i];
+				}
+				else if (temp == "--FLUSH-INTERVAL") {
+					if ((i + 1) >= argc) throw 1;
+					flush_interval = CONVERT<int>(argv[++i]);
+					if (flush_interval < 0) throw 1;
 				}
 				else throw 1;
 			}
@@ -527,6 +919,8 @@ bool KNKS::parseParameter(int argc, const char* argv[]) {
 			if (mutation_rate != NA && output_coding_flag == 1) {
 				throw 1;
 			}
+			//Keep saving checkpoints when resuming
+			if (resume && checkpoint_interval < 0) checkpoint_interval = 60;
 		}
 	}
 	catch (...) {
@@ -611,7 +1005,11 @@ void KNKS::showParaInfo() {
 		cout << "Output file: " << output_nc_filename << endl;
 	}
 
-	cout << "Genetic code: " << transl_table[2 * (genetic_code - 1) + 1] << endl;
+	cout << "Genetic code: " << transl_table[2 * (ctx.genetic_code - 1) + 1] << endl;
+	if (threads > 1) cout << "Threads: " << threads << endl;
+	if (shard != "" || records != "") cout << "Records: " << first_record + 1 << "-" << last_record << endl;
+	if (mutation_rate == NA && join_names) cout << "Coding pairs: by the same names" << endl;
+	else if (mutation_rate == NA && join_filename != "") cout << "Coding pairs: by the names in " << join_filename << endl;
 	cout << "Please wait while reading sequences and calculating..." << endl;
 }
 
@@ -698,12 +1096,24 @@ void KNKS::helpInfo() {
 	cout << "\t\t  (More information about the Genetic Codes: http://www.ncbi.nlm.nih.gov/Taxonomy/Utils/wprintgc.cgi?mode=c)" << endl;
 	
 	
+	cout << "\t-t\tNumber of threads for calculating coding pairs in parallel, results are kept in the input order [int, default = 1]" << endl;
+	cout << "\t--shard\tCalculate only the i-th of N nearly equal parts of the records, e.g. 3/200 for a job array [string, i/N]" << endl;
+	cout << "\t--records\tCalculate only the records from a to b, counted from 1 [string, a-b]" << endl;
+	cout << "\t\t  (Both seek by the indexes '<input file>" << AXTINDEX_SUFFIX << "' saved by " << AXTINDEX_NAME << ", or else scan the files first)" << endl;
+	cout << "\t--join-names\tPair each noncoding record with the coding record of the same name, instead of the one in the same order" << endl;
+	cout << "\t--join-map\tPair the records by a file of lines 'noncoding name<TAB>coding name', in any order, instead of the one of records [string]" << endl;
+	cout << "\t\t  (Coding records are found by an index of their names; a noncoding record without one is reported and uses the last estimates)" << endl;
+	cout << "\t--checkpoint\tSave the progress into '<output file>" << CHECKPOINT_SUFFIX << "' every given seconds [int]" << endl;
+	cout << "\t--resume\tContinue an interrupted run from its checkpoint, saving checkpoints every 60 seconds by default" << endl;
+	cout << "\t--flush-interval\tSeconds between writes of the output buffered in memory, 0 for writing each pair at once [int, default = " << WRITER_INTERVAL << "]" << endl;
 	cout << "\t-h\tHelp information" << endl;
 	cout << endl;
 
 	cout << "Example:" << endl;
 	cout << "\t" << KNKS_NAME << " -i test.axt -j adj.axt -o test.axt.knks\t//use 'adj.axt' to deduce neutral mutation rate" << endl;
 	cout << "\t" << KNKS_NAME << " -i test.axt -j 0.618   -o test.axt.knks\t//use 0.618 as netural mutation rate" << endl;
+	cout << "\t" << KNKS_NAME << " -i test.axt -j adj.axt -o test.axt.knks.3 --shard 3/200\t//on the 3rd of 200 parts" << endl;
+	cout << "\t" << KNKS_NAME << " -i test.axt -j adj.axt -o test.axt.knks --join-map adj.txt\t//pair the records by the names in 'adj.txt'" << endl;
 	
 	cout << endl;
 
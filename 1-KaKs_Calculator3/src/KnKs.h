@@ -13,10 +13,43 @@
 #define  KNKS_H
 
 #include "base.h"
+#include "Parallel.h"
+#include "AXTIndex.h"
+#include "AXTReader.h"
+#include "Checkpoint.h"
+#include "AsyncWriter.h"
 #include "GY94.h"
 
+#include<unordered_map>
+
 using namespace std;
 
+/* Estimates of the coding pair adjacent to a noncoding pair, calculated independently of other pairs */
+struct KnKsPair {
+	/* Index of the pair among the records read */
+	unsigned long index;
+	/* Noncoding pair: name and both sequences one after the other */
+	string name, str;
+	/* Name of the adjacent coding pair */
+	string cds_name;
+	/* Coding pair valid or not, and the error message if not */
+	bool cds_valid;
+	string cds_msg;
+	/* Coding pair after deleting gaps and stop codons */
+	string seq1, seq2;
+	/* Number of coding pairs calculated before this one */
+	unsigned long runs;
+	/* Row of GY for the details of coding estimates */
+	string cds_result;
+	/* Estimates of GY */
+	double Ka, Ks, snp, kappa, GC[4];
+	unsigned long cds_len;
+	/* Calculated successfully or not, finished or not */
+	bool ok, done;
+
+	KnKsPair(): index(0), cds_valid(false), runs(0), Ka(0), Ks(0), snp(0), kappa(0), cds_len(0), ok(true), done(false) {}
+};
+
 /* KAKS class */
 class KNKS : public Base {
 public:
@@ -35,12 +68,27 @@ public:
 	/* Check whether str is numeric */
 	bool isNum(string str);
 
-	/* Get results for Windows */
+	/* Get results for Windows, kept after 'keepResult4Win' */
 	string getResult4Win();
+	/* Keep the rows written in 'result4Win', as the Windows version shows them */
+	void keepResult4Win();
+
+	/* Receiver of the rows of each pair as written, none by default so that no rows are kept */
+	function<void(const string &rows)> result_sink;
 
 protected:
 	/* Use several methods to calculate ka/ks */
 	bool calculateKnKs(string seq1, string seq2);
+	/* Calculate Ks of the adjacent coding pair, called by the threads */
+	void calculateCDS(KnKsPair &pair);
+	/* Calculate Kn and write the results of a pair in the input order */
+	void writeResult(KnKsPair &pair);
+	/* Read the names of coding pairs for a join by name, and their offsets in coding file */
+	bool loadJoin(AXTReader &cds);
+	/* Save the progress after the records written, with the estimates kept for the next ones */
+	bool saveCheckpoint(unsigned long done);
+	/* Restore the progress of an interrupted run, giving the records done */
+	bool restoreCheckpoint(unsigned long &done);
 	/* Get corrected distance based on JC69 */
 	double getDistanceJC69(double d);
 	/* Get corrected distance based on JC69 */
@@ -55,7 +103,7 @@ protected:
 
 	/* Check the sequence whether is valid or not */
 	bool checkNCValid(string name, string str);
-	bool checkValid(string name, string str);
+	bool checkValid(const string &str, string &seq1, string &seq2, string &msg);
 	/* Parse the input parameters */
 	bool parseParameter(int argc, const char* argv[]);
 	/* Show input parameters' information on screen */
@@ -91,20 +139,47 @@ public:
 	string output_coding_filename;
 	/* Sequence count */
 	int number;
+	/* Number of threads for calculating pairs in parallel */
+	int threads;
+	/* Records selected by "--shard i/N" or "--records a-b", all if both empty */
+	string shard, records;
+	/* Selected records from first to last (excluded), counted from 0 */
+	unsigned long first_record, last_record;
+	/* Pair noncoding and coding records by the same name, or by the names in 'join_filename',
+	   instead of by their order */
+	bool join_names;
+	string join_filename;
+	/* Seconds between checkpoints, -1 for none */
+	int checkpoint_interval;
+	/* Seconds between writes of buffered output */
+	int flush_interval;
+	/* Continue from the checkpoint of an interrupted run */
+	bool resume;
 	/* Running time */
 	int hh, mm, ss;
 
 private:
 	/* Noncoding results */
 	string nc_result;
-	/* Detailed coding results */
-	string coding_result;
-	/* Output stream */
-	ofstream os;
+	/* Output stream, written by its own thread */
+	AsyncWriter os;
+	/* Stream of detailed coding results, written as the pairs */
+	AsyncWriter cds_os;
+	/* Bytes written into output file and coding file */
+	long long output_length, coding_length;
+	/* Number of coding pairs calculated and written */
+	unsigned long cds_runs;
+	/* Progress of the run */
+	Checkpoint checkpoint;
 	/* A pair of sequence */
 	string seq1, seq2;
 
-	/* CDS method */
+	/* Coding names by noncoding names, read from 'join_filename' */
+	unordered_map<string, string> join_map;
+	/* Offsets of the coding pairs by name, for a join */
+	unordered_map<string, long long> coding_offsets;
+
+	/* Estimates of the last valid coding pair */
 	GY94 zz;
 
 };
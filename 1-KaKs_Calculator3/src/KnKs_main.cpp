@@ -19,7 +19,7 @@ int main(int argc, const char* argv[]) {
 		if(!kk.Run(argc, argv)) throw 1;
 	}
 	catch (...) {
-		
+		return 1;
 	}
 	return 0;
 }
@@ -25,12 +25,12 @@
 
 #include "LPB93.h"
 
-LPB93::LPB93() {
+LPB93::LPB93(const Context &c): LWL85(c) {
 	name = "LPB";
 }
 
 /* Similar to LWL85 except the formulas for calculating ka and ks*/
-string LPB93::Run(string seq1, string seq2) {
+string LPB93::Run(const string &seq1, const string &seq2) {
 
 	preProcess(seq1, seq2);
 	
@@ -50,8 +50,9 @@ string LPB93::Run(string seq1, string seq2) {
 
 
 /*The difference between LPB93 and MLPB93 focuses on the definition of transition & transversion*/
-MLPB93::MLPB93() {
+MLPB93::MLPB93(const Context &c): LPB93(c) {
 	name = "MLPB";
+	modified = true;
 }
 
 /*For more detail see reference: Tzeng Y-H, Pan R, Li W-H  (2004)  Mol. Biol. Evol.*/
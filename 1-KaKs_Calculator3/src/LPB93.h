@@ -34,16 +34,16 @@ using namespace std;
 class LPB93: public LWL85 {
 	
 public:
-	LPB93();
+	LPB93(const Context &c);
 	/* Main function of calculating kaks */
-	string Run(string seq1, string seq2);
+	string Run(const string &seq1, const string &seq2);
 }; 
 
 
 class MLPB93: public LPB93 {
 	
 public:
-	MLPB93();
+	MLPB93(const Context &c);
 
 protected:
 	/* Calculate the transition & transversion between two codons at a given position*/
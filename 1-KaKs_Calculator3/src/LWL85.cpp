@@ -22,11 +22,14 @@
 
 #include "LWL85.h"
 
+#include<mutex>
 
-LWL85::LWL85() {
+
+LWL85::LWL85(const Context &c): Base(c) {
 	int i;
 
 	name = "LWL";	
+	modified = false;
 	for(i=0; i<5; i++) K[i] = A[i] = B[i] = Pi[i] = Qi[i] = 0;
 }
 
@@ -129,30 +132,12 @@ void LWL85::CountSiteAndDiff(string codon1, string codon2) {
 /************************************************
 * Function: getCodonClass
 * Input Parameter: codon, position(0,1,2)
-* Output: return 0,2,4-fold of codon at a given position.
+* Output: return 0,2,4-fold of codon at a given position,
+		 by the synonymous changes at the position.
 * Return Value: 0 or 2 or 4
 *************************************************/
-int LWL85::getCodonClass(string codon, int pos) {
-	int i;
-	int codonClass = 0;
-
-	for(i=0; i<4; i++) {
-		if (i!=convertChar(codon[pos])) {
-			string temp = codon;
-			temp[pos] = convertInt(i);
-			if (getAminoAcid(temp)!='!' && getAminoAcid(temp)==getAminoAcid(codon)) {
-				codonClass++;
-			}
-		}
-	}
-	if (codonClass>0 && codonClass<3) {
-		codonClass = 2;
-	}
-	else if (codonClass==3) {
-		codonClass = 4;
-	}
-
-	return codonClass;		
+int LWL85::getCodonClass(const string &codon, int pos) {
+	return codonTable().fold[getID(codon.c_str())][pos];
 }
 
 /************************************************
@@ -205,21 +190,102 @@ int LWL85::TransitionTransversion(string codon1, string codon2, int pos) {
 	return 1;
 }
 
+/************************************************
+* Function: getPairSums
+* Input Parameter: void
+* Output: Count the sites and differences of each pair of
+		 codons alone, the first time the method is used
+		 with the genetic code. The methods differ by
+		 'TransitionTransversion', so the sums are kept
+		 by the name of the method.
+* Return Value: vector of PairSums
+*************************************************/
+const vector<LWL85::PairSums> &LWL85::getPairSums() {
+
+	//LWL and LPB share a table, as do MLWL and MLPB
+	static vector<PairSums> tables[2][NCODE];
+	static once_flag built[2][NCODE];
+
+	vector<PairSums> &table = tables[modified][ctx.genetic_code-1];
+	call_once(built[modified][ctx.genetic_code-1], [this, &table]() {
+		int i, k;
+
+		table.resize(CODON*CODON);
+		for (k=0; k<CODON*CODON; k++) {
+			for(i=0; i<5; i++) L[i] = Si[i] = Vi[i] = 0;
+			snp = 0;
+			CountSiteAndDiff(getCodon(k/CODON), getCodon(k%CODON));
+
+			PairSums &sums = table[k];
+			for(i=0; i<5; i++) {
+				sums.L[i] = L[i];
+				sums.Si[i] = Si[i];
+				sums.Vi[i] = Vi[i];
+			}
+			sums.snp = snp;
+		}
+		for(i=0; i<5; i++) L[i] = Si[i] = Vi[i] = 0;
+		snp = 0;
+	});
+
+	return table;
+}
+
+void LWL85::countPairs(const string &seq1, const string &seq2) {
+
+	long i;
+	int j;
+
+	//Sums counted by the method with the same transitions and transversions already
+	SharedStages *stages = getStages(seq1, seq2);
+	if (stages!=NULL && stages->lwl[modified].done) {
+		for(j=0; j<5; j++) {
+			L[j] = stages->lwl[modified].L[j];
+			Si[j] = stages->lwl[modified].Si[j];
+			Vi[j] = stages->lwl[modified].Vi[j];
+		}
+		snp = stages->lwl[modified].snp;
+		return;
+	}
+
+	CodonPairCounts local;
+	const CodonPairCounts &counts = getCodonPairs(seq1, seq2, local);
+	const vector<PairSums> &table = getPairSums();
+	//Added in the order of the pairs of codons, as Fisher's test is sensitive to rounding
+	for(i=0; i<counts.positions.size(); i++) {
+		const PairSums &sums = table[counts.pairs[counts.positions[i]]];
+		for(j=0; j<5; j+=2) {
+			L[j] += sums.L[j];
+			Si[j] += sums.Si[j];
+			Vi[j] += sums.Vi[j];
+		}
+		snp += sums.snp;
+	}
+
+	if (stages!=NULL) {
+		for(j=0; j<5; j++) {
+			stages->lwl[modified].L[j] = L[j];
+			stages->lwl[modified].Si[j] = Si[j];
+			stages->lwl[modified].Vi[j] = Vi[j];
+		}
+		stages->lwl[modified].snp = snp;
+		stages->lwl[modified].done = true;
+	}
+}
+
 /************************************************
 * Function: preProcess
 * Input Parameter: seq1, seq2
 * Output: preprocess for Run
 * Return Value: void
 *************************************************/
-void LWL85::preProcess(string seq1, string seq2) {
+void LWL85::preProcess(const string &seq1, const string &seq2) {
 
 	long i;
 	double ts=0, tv=0;
 	double ai[5], bi[5];
 	
-	for(i=0; i<seq1.length(); i+=3) {		
-		CountSiteAndDiff(seq1.substr(i,3), seq2.substr(i,3));
-	}
+	countPairs(seq1, seq2);
 
 	for(i=0; i<5; i+=2) {		
 		
@@ -269,7 +335,7 @@ void LWL85::preProcess(string seq1, string seq2) {
 * Output: Main function for calculating Ka&Ks.
 * Return Value: void
 *************************************************/
-string LWL85::Run(string seq1, string seq2) {
+string LWL85::Run(const string &seq1, const string &seq2) {
 	
 	preProcess(seq1, seq2);
 
@@ -289,8 +355,9 @@ string LWL85::Run(string seq1, string seq2) {
 
 
 
-MLWL85::MLWL85() {
+MLWL85::MLWL85(const Context &c): LWL85(c) {
 	name = "MLWL";
+	modified = true;
 }
 
 
@@ -341,15 +408,13 @@ int MLWL85::TransitionTransversion(string codon1, string codon2, int pos) {
 }
 
 /* One of differences between MLWL85 and LWL85 is allowing for kappa in S and N */
-string MLWL85::Run(string stra, string strb) {
+string MLWL85::Run(const string &stra, const string &strb) {
 
 	long i;
 	double ts=0.0, tv=0.0;	//Transition, Transversion
 	double ai[5], bi[5];	
 	
-	for(i=0; i<stra.length(); i+=3) {
-		this->CountSiteAndDiff(stra.substr(i,3), strb.substr(i,3));
-	}
+	countPairs(stra, strb);
 	
 	for(i=0; i<5; i+=2) {
 		
@@ -47,18 +47,27 @@ const int CodonClassDict[]={0,0,2,  0,0,2,	2,0,2,  2,0,2,	0,0,4,  0,0,4,	0,0,4,
 class LWL85: public Base {
 	
 public:
-	LWL85();
+	LWL85(const Context &c);
 
 	/* Main function for calculating Ka&Ks */
-	string Run(string seq1, string seq2);
+	string Run(const string &seq1, const string &seq2);
 
 protected:
+	/* Contributions of a pair of codons to the sums */
+	struct PairSums {
+		double L[5], Si[5], Vi[5], snp;
+	};
+	/* Contributions of each pair of codons (id1*CODON+id2) by this method's transitions and transversions in the genetic code, built once */
+	const vector<PairSums> &getPairSums();
+	/* Sum the sites and differences of two sequences, by the pairs of codons */
+	void countPairs(const string &seq1, const string &seq2);
+
 	/* preprocess in main function of Run */
-	void preProcess(string seq1, string seq2);
+	void preProcess(const string &seq1, const string &seq2);
 	/* Calculate synonymous and nonsynonymous sites and differences on two compared codons */
 	void CountSiteAndDiff(string str1, string str2);
 	/* Return 0,2,or 4 of the codon at a given position */
-	int  getCodonClass(string codon, int pos);
+	int  getCodonClass(const string &codon, int pos);
 	/* Calculate synonymous and nonsynonymous differences of two codons at a given position */
 	virtual int  TransitionTransversion(string codon1, string codon2, int pos);
 
@@ -73,16 +82,18 @@ public:
 protected:
 	/* Number of synonymous and nonsynonymous differences of pair-codon */
 	double Si_temp[5], Vi_temp[5];	
+	/* Transitions and transversions as modified by Tzeng et al. (MLWL and MLPB) */
+	bool modified;
 }; 
 
 
 class MLWL85: public LWL85 {
 	
 public:
-	MLWL85();
+	MLWL85(const Context &c);
 
 	/* Main function for calculating Ka&Ks */
-	string Run(string str1, string str2);
+	string Run(const string &str1, const string &str2);
 	
 protected:
 	/* Calculate the transition & transversion between two codons at a given position*/
@@ -0,0 +1,211 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: MAFReader.cpp
+* Abstract: Definition of a reader of MAF file of multiple
+			alignments, giving pairs of sequences in each
+			block as records of axt file.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+
+#include "MAFReader.h"
+
+#include<stdlib.h>
+
+/* Split a line into its words */
+static void splitWords(string_view line, vector<string_view> &words) {
+
+	words.clear();
+	size_t i = 0, j;
+	while ((i = line.find_first_not_of(" \t\r", i)) != string_view::npos) {
+		j = line.find_first_of(" \t\r", i);
+		if (j == string_view::npos) j = line.length();
+		words.push_back(line.substr(i, j - i));
+		i = j;
+	}
+}
+
+MAFReader::MAFReader() {
+	species1 = species2 = name = "";
+	block_start = block_end = current = skip = 0;
+	overflow = false;
+}
+
+/****************************************************
+* Function: open
+* Input Parameter: string, string
+* Output: Open the file, selecting the pairs of two species
+		  "species1,species2", or all pairs by "ALL".
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool MAFReader::open(string filename, string species) {
+
+	species1 = species2 = "";
+	if (species != MAF_ALL_PAIRS) {
+		size_t i = species.find(',');
+		if (i == string::npos) return false;
+		species1 = species.substr(0, i);
+		species2 = species.substr(i + 1);
+		if (species1 == "" || species2 == "" || species1 == species2) return false;
+	}
+
+	rows.clear();
+	pairs.clear();
+	current = skip = 0;
+	overflow = false;
+
+	return AXTReader::open(filename);
+}
+
+void MAFReader::seek(long long position) {
+
+	AXTReader::seek(position / MAF_PAIRS_MAX);
+	skip = position % MAF_PAIRS_MAX;
+	rows.clear();
+	pairs.clear();
+	current = 0;
+}
+
+/****************************************************
+* Function: readBlock
+* Input Parameter: void
+* Output: Skip to the next line "a", and read the lines "s"
+		  of its block until a blank line. Then select the
+		  pairs: the first sequences of the two species,
+		  or every two sequences for all pairs.
+* Return Value: True if a block is read, false at the end
+		  of file or if the block has too many pairs.
+*****************************************************/
+bool MAFReader::readBlock() {
+
+	rows.clear();
+	pairs.clear();
+	current = 0;
+	release();
+
+	string_view line;
+	vector<string_view> words;
+	size_t start = pos;
+	while (getLine(line) && (line.length() == 0 || line[0] != 'a')) start = pos;
+	if (line.length() == 0) return false;
+	block_start = start;
+
+	while (getLine(line) && line.find_first_not_of(" \t\r") != string_view::npos) {
+		if (line[0] != 's') continue;
+		splitWords(line, words);
+		if (words.size() != 7) continue;
+
+		MAFRow row;
+		row.src = words[1];
+		row.species = row.src.substr(0, row.src.find('.'));
+		row.start = words[2];
+		row.size = words[3];
+		row.strand = words[4];
+		row.text = words[6];
+		rows.push_back(row);
+	}
+	block_end = pos;
+
+	size_t i, j;
+	if (species1 == "") {
+		for (i = 0; i < rows.size(); i++) {
+			for (j = i + 1; j < rows.size(); j++) pairs.push_back(make_pair(i, j));
+		}
+	}
+	else {
+		size_t first = rows.size(), second = rows.size();
+		for (i = 0; i < rows.size(); i++) {
+			if (first == rows.size() && rows[i].species == species1) first = i;
+			if (second == rows.size() && rows[i].species == species2) second = i;
+		}
+		if (first < rows.size() && second < rows.size()) pairs.push_back(make_pair(first, second));
+	}
+	//Its positions would run into the next block's, so the reading stops
+	if (pairs.size() > MAF_PAIRS_MAX) {
+		cout << "Error. More than " << MAF_PAIRS_MAX << " pairs in the block at " << block_start << endl;
+		rows.clear();
+		pairs.clear();
+		overflow = true;
+		return false;
+	}
+
+	return true;
+}
+
+string MAFReader::getRowName(const MAFRow &row) {
+
+	unsigned long start = strtoul(string(row.start).c_str(), NULL, 10);
+	unsigned long size = strtoul(string(row.size).c_str(), NULL, 10);
+
+	return string(row.src) + ":" + to_string(start) + "-" + to_string(start + size) + ":" + string(row.strand);
+}
+
+/****************************************************
+* Function: next
+* Input Parameter: AXTRecord
+* Output: Give the next pair selected, reading blocks until
+		  one has it. The texts are cut to whole codons
+		  from the start of the block.
+* Return Value: True if a pair is read, otherwise false.
+*****************************************************/
+bool MAFReader::next(AXTRecord &rec) {
+
+	rec.lines.clear();
+	rec.length = 0;
+	rec.kept = !zipped;
+
+	while (current >= pairs.size()) {
+		if (!readBlock()) return false;
+		current = skip;
+		skip = 0;
+	}
+
+	const MAFRow &row1 = rows[pairs[current].first], &row2 = rows[pairs[current].second];
+	size_t n = row1.text.length() < row2.text.length() ? row1.text.length() : row2.text.length();
+	n -= n % 3;
+
+	name = getRowName(row1) + "&" + getRowName(row2);
+	rec.name = name;
+	rec.lines.push_back(row1.text.substr(0, n));
+	rec.lines.push_back(row2.text.substr(0, n));
+	rec.length = 2 * n;
+
+	current++;
+	if (current < pairs.size()) rec.end = (long long)block_start * MAF_PAIRS_MAX + current;
+	else rec.end = (long long)block_end * MAF_PAIRS_MAX;
+
+	return true;
+}
+
+/****************************************************
+* Function: index
+* Input Parameter: AXTIndex
+* Output: Scan the blocks for the position of each pair,
+		  then go back to the current position.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool MAFReader::index(AXTIndex &idx) {
+
+	size_t offset = pos, k;
+	idx.offsets.clear();
+	idx.file_size = size;
+
+	AXTReader::seek(0);
+	while (readBlock()) {
+		for (k = 0; k < pairs.size(); k++) idx.offsets.push_back((long long)block_start * MAF_PAIRS_MAX + k);
+	}
+
+	AXTReader::seek(offset);
+	rows.clear();
+	pairs.clear();
+	current = skip = 0;
+
+	return !isFailed();
+}
+
+bool MAFReader::isFailed() {
+	return overflow || AXTReader::isFailed();
+}
@@ -0,0 +1,83 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: MAFReader.h
+* Abstract: Declaration of a reader of MAF file of multiple
+			alignments, giving pairs of sequences in each
+			block as records of axt file.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+#if !defined(MAFREADER_H)
+#define  MAFREADER_H
+
+#include<string>
+#include<string_view>
+#include<vector>
+
+#include "AXTReader.h"
+#include "AXTIndex.h"
+
+using namespace std;
+
+/* Pairs of a block at most. The position of a pair is the offset of its
+   block times this number plus its number in the block, so that a
+   position serves for seeking, selecting and checkpoints as an offset */
+#define MAF_PAIRS_MAX (1 << 20)
+/* Selecting all pairs of sequences in each block */
+#define MAF_ALL_PAIRS "ALL"
+
+/* A sequence line "s src start size strand srcSize text" of a block */
+struct MAFRow {
+	/* Source "species.chromosome", and the species before the first '.' */
+	string_view src, species;
+	/* Start, size and strand as in the line */
+	string_view start, size, strand;
+	/* Aligned text */
+	string_view text;
+};
+
+/* Blocks of MAF file, read as they are needed. Each pair of the species
+   selected in a block is a record, whose two lines are the aligned texts
+   cut to whole codons, named "src1:start-end:strand&src2:..." */
+class MAFReader: public AXTReader {
+
+public:
+	MAFReader();
+
+	/* Open MAF file, giving the pairs of species "species1,species2" or all pairs by "ALL" */
+	bool open(string filename, string species);
+	/* Go to the position of a pair */
+	void seek(long long position);
+	/* Get the next pair, false at the end of file */
+	bool next(AXTRecord &rec);
+	/* Scan the file for the position of each pair */
+	bool index(AXTIndex &idx);
+	/* Whether a block had too many pairs, or decompressing failed */
+	bool isFailed();
+
+protected:
+	/* Read the sequence lines of the next block, false at the end of file */
+	bool readBlock();
+	/* Name of a sequence in a pair */
+	string getRowName(const MAFRow &row);
+
+	/* Species selected, both empty for all pairs */
+	string species1, species2;
+	/* Sequences of the block read */
+	vector<MAFRow> rows;
+	/* Rows of the pairs selected in the block */
+	vector< pair<size_t, size_t> > pairs;
+	/* Offsets of the block and of the file after it */
+	size_t block_start, block_end;
+	/* Next pair in the block, and the one to go on from after 'seek' */
+	size_t current, skip;
+	/* Name of the last pair, viewed by the record */
+	string name;
+	/* Whether a block had more than MAF_PAIRS_MAX pairs */
+	bool overflow;
+};
+
+#endif
@@ -23,24 +23,22 @@
 *************************************************************/
 #include "MSMA.h"
 
-MS::MS() {
+MS::MS(const Context &c): Base(c) {
 	name = "MS";
 }
 
 /* Calculate Ka and Ks based on a given model, similar to the method of GY */
-void MS::selectModel(const char *seq1, const char *seq2, string c_model, vector<MLResult>& result4MA) {
+void MS::selectModel(const char *seq1, const char *seq2, string c_model, MLResult &tmp) {
 
-	MLResult tmp;
-	GY94 zz(c_model);	
+	//Keep the row of the model, formatted after adding its Akaike weight
+	vector<ResultRow> rows;
+	Context c = ctx;
+	c.rows = &rows;
+	GY94 zz(c, c_model);	
 
-	tmp.result = zz.Run(seq1, seq2);
-	tmp.AICc = zz.AICc;
-	copyArray(zz.com.pi, tmp.freq, (int)CODON);
-	copyArray(zz.KAPPA, tmp.rate, (int)NUMBER_OF_RATES);
-	tmp.w = zz.com.omega;
-	tmp.t = 3.*zz.t;
-
-	result4MA.push_back(tmp);
+	zz.Run(seq1, seq2);
+	if (rows.size() != 1) throw 1;
+	zz.getMLResult(tmp);
 }
 
 /* Choose the estimates under a model with smallest AICc */
@@ -49,8 +47,28 @@ string MS::Run(const char *seq1, const char *seq2, vector<MLResult> &result4MA,
 	int i, j, pos;
 	string candidate_models[] = {"JC", "F81", "K2P", "HKY", "TNEF", "TN", "K3P", "K3PUF", "TIMEF", "TIM", "TVMEF", "TVM", "SYM", "GTR"};
 	
-	//Calculate Ka and Ks using 14 models
-	for (i=0; i<MODELCOUNT; i++) selectModel(seq1, seq2, candidate_models[i], result4MA);
+	//Calculate Ka and Ks using 14 models, which are independent and fitted in parallel,
+	//except HKY if fitted by GY on the pair already
+	SharedStages *stages = (ctx.stages!=NULL && ctx.stages->isPair(seq1, seq2)) ? ctx.stages : NULL;
+	result4MA.resize(MODELCOUNT);
+	bool isOK[MODELCOUNT];
+	TaskGroup group;
+	for (i=0; i<MODELCOUNT; i++) {
+		isOK[i] = false;
+		if (candidate_models[i]=="HKY" && stages!=NULL && stages->fitted) {
+			result4MA[i] = stages->gy;
+			isOK[i] = true;
+			continue;
+		}
+		group.run([this, seq1, seq2, &candidate_models, &result4MA, &isOK, i]() {
+			selectModel(seq1, seq2, candidate_models[i], result4MA[i]);
+			isOK[i] = true;
+		});
+	}
+	group.wait();
+	for (i=0; i<MODELCOUNT; i++) {
+		if (!isOK[i]) throw 1;
+	}
 
 	//Choose the results under a model with smallest AICc
 	for (pos=i=0; i<result4MA.size(); i++) {		
@@ -78,41 +96,37 @@ string MS::Run(const char *seq1, const char *seq2, vector<MLResult> &result4MA,
 	}
 
 	//Add Akaike weights to results
-	string tmp="";
 	for (i=0; i<MODELCOUNT; i++) {
-
-		//Add akaike weights
-		tmp = result4MA[i].result;
-		j = tmp.find_last_of('\t');
-		result4MA[i].result = tmp.substr(j, tmp.length()-j);
-		tmp = tmp.replace(j, tmp.length()-j, "");
-		j = tmp.find_last_of('\t');
-		tmp = tmp.replace(j+1, tmp.length()-j-1, "") + CONVERT<string>(w[i]);
-		result4MA[i].result = tmp + result4MA[i].result;
+		result4MA[i].row.AkaikeWeight = w[i];
 
 		//Details on model selection
-		details += result4MA[i].result;
+		formatRow(result4MA[i].row, details);
 	}
 
 	//Results at "pos" is more reliable, replace 'method name' by "MS".
-	tmp = result4MA[pos].result;	
-	i = tmp.find('\t');
-	j = tmp.find('\t', i+1);	
-	result4MA[pos].result  = tmp.substr(0, i+1) + name;
-	result4MA[pos].result += tmp.substr(j, tmp.length()-j);
+	ResultRow row = result4MA[pos].row;
+	row.method = name;
+
+	if (ctx.rows != NULL) {
+		ctx.rows->push_back(row);
+		return "";
+	}
+
+	string result = "";
+	formatRow(row, result);
 
-	return result4MA[pos].result;
+	return result;
 }
 
 
-MA::MA() {
+MA::MA(const Context &c): GY94(c) {
 	name = "MA";
 	Small_Diff=1e-6; 
 	w_rndu=123456757;
 	com.ns = 2; 
 	lnL = 0.0;
 
-	com.icode = genetic_code-1;
+	com.icode = ctx.genetic_code-1;
 	if (com.icode>11) com.icode = 0;	
 	com.ncode = Nsensecodon = 64 - getNumNonsense(com.icode);
 
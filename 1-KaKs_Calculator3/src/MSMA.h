@@ -25,6 +25,7 @@
 #if !defined(MA_H)
 #define  MA_H
 
+#include "Parallel.h"
 #include "GY94.h"
 
 using namespace std;
@@ -33,13 +34,13 @@ using namespace std;
 class MS: public Base {
 
 public:	
-	MS();
+	MS(const Context &c);
 	/* Main function */
 	string Run(const char *seq1, const char *seq2, vector<MLResult> &result4MA, string &details);
 
 protected:
 	/* Calculate Ka and Ks based on a given model */
-	void selectModel(const char *seq1, const char *seq2, string candidate_model, vector<MLResult> &result4MA);
+	void selectModel(const char *seq1, const char *seq2, string candidate_model, MLResult &result);
 
 };
 
@@ -47,7 +48,7 @@ protected:
 class MA: public GY94 {
 
 public:	
-	MA();
+	MA(const Context &c);
 	
 	/* Main function */
 	string Run(const char *seq1, const char *seq2, vector<MLResult> result4MA);
@@ -17,19 +17,21 @@
 
 #include "MYN.h"
 
-MYN::MYN() {
+MYN::MYN(const Context &c): YN00(c) {
 	name = "MYN";
 }
 
 /* Get the two kappas between purines and between pyrimidines */
-int MYN::GetKappa(const string seq1, const string seq2) {
+int MYN::GetKappa(const string &seq1, const string &seq2) {
 
-	int i,j,k,h,pos,c[2],aa[2],b[2][3],nondeg,fourdeg,by[3]={16,4,1};
+	int j,k,h,pos,c[2],aa[2],b[2][3],nondeg,fourdeg;
 	double kappatc_TN[2], kappaag_TN[2], kappa_TN[2];
 	double F[2][XSIZE], S[2], wk[2], pi4[4]; 
 	double T1, T2, V;//proportions of transitional differences between purines and between
 	double kdefault=2, nullValue=NULL;
 		
+	const CodonTable &table = codonTable();
+
 	for(k=0; k<2; k++)
 		initArray(F[k],16);
 	
@@ -37,11 +39,11 @@ int MYN::GetKappa(const string seq1, const string seq2) {
 	for(h=0; h<seq1.length(); h+=3) {
 		
 		//c[]: amino acid(0--63)
-		c[0]=getID(seq1.substr(h,3));
-		c[1]=getID(seq2.substr(h,3));
+		c[0]=getID(seq1.c_str()+h);
+		c[1]=getID(seq2.c_str()+h);
 		//aa[ ]: amino acid
-		aa[0]=getAminoAcid(c[0]);
-		aa[1]=getAminoAcid(c[1]);		
+		aa[0]=table.aa[c[0]];
+		aa[1]=table.aa[c[1]];		
 		//b[][]: 0--3
 		for(j=0; j<3; j++) {
 			b[0][j] = convertChar(seq1[h+j]);
@@ -51,12 +53,7 @@ int MYN::GetKappa(const string seq1, const string seq2) {
 		//Find non-degenerate sites
 		for(pos=0; pos<3; pos++) {        
 			for(k=0,nondeg=0; k<2; k++) {
-				for(i=0; i<4; i++) {
-					if(i!=b[k][pos]) 						
-						if (getAminoAcid(c[k]+(i-b[k][pos])*by[pos])==aa[k]) 
-							break;					
-				}
-				if (i==4) 
+				if (table.nondegenerate[c[k]][pos]) 
 					nondeg++;
 			}
 			//F[0][]: 0-fold
@@ -68,10 +65,7 @@ int MYN::GetKappa(const string seq1, const string seq2) {
 		
 		//Find 4-fold degenerate sites at 3rd position
 		for(k=0,fourdeg=0;k<2;k++) {
-			for(j=0,i=c[k]-b[k][2]; j<4; j++) 
-				if(j!=b[k][2] && getAminoAcid(i+j)!=aa[k])
-					break;
-			if(aa[0]==aa[1] && j==4)
+			if(aa[0]==aa[1] && table.fourfold[c[k]])
 				fourdeg++;
 		}
 		//F[1][]: 4-fold
@@ -307,7 +301,7 @@ int MYN::CorrectKaksTN93(double n, double P1, double P2, double Q, double pi4[],
 }
 
 /* Count differences, considering different transitional pathways between purines and between pyrimidines */
-int MYN::CountDiffs(const string seq1, const string seq2, double &Sdts1, double &Sdts2, double &Sdtv,double &Ndts1, double &Ndts2, double &Ndtv,double PMatrix[]) {
+int MYN::CountDiffs(const CodonPairCounts &counts, double &Sdts1, double &Sdts2, double &Sdtv,double &Ndts1, double &Ndts2, double &Ndtv,double PMatrix[]) {
 	int h,i1,i2,i,k, transi, c[2],ct[2], by[3]={16,4,1};
 	char aa[2];
 	int dmark[3], step[3], b[2][3], bt1[3], bt2[3];
@@ -315,11 +309,17 @@ int MYN::CountDiffs(const string seq1, const string seq2, double &Sdts1, double
 	double sts1, sts2, stv, nts1, nts2, ntv; /* syn ts & tv, nonsyn ts & tv for 2 codons */
 	double ppath[6], sump,p;
 
+	//Differences of each pair of codons, summed in the order of the codons
+	//as Fisher's test is sensitive to rounding: ndiff, sts1, sts2, stv, nts1, nts2, ntv
+	const int NDIFFS=7;
+	vector<double> diffs(counts.pairs.size()*NDIFFS, 0.0);
+
 	Sdts1=Sdts2=Sdtv=Ndts1=Ndts2=Ndtv=snp=0;
-	for (h=0; h<seq1.length(); h+=3)  {		
+	for (h=0; h<counts.pairs.size(); h++)  {		
 
-		c[0]=getID(seq1.substr(h,3));
-		c[1]=getID(seq2.substr(h,3));
+		//Each pair of codons once
+		c[0]=counts.pairs[h]/CODON;
+		c[1]=counts.pairs[h]%CODON;
 		//Difference?
 		if (c[0]==c[1])
 			continue;
@@ -341,7 +341,7 @@ int MYN::CountDiffs(const string seq1, const string seq2, double &Sdts1, double
 				dmark[ndiff++]=k;
 		}
 
-		snp+=ndiff;
+		diffs[h*NDIFFS]=ndiff;
 
 		npath=1;
 		if(ndiff>1)
@@ -463,20 +463,28 @@ int MYN::CountDiffs(const string seq1, const string seq2, double &Sdts1, double
 			
 		}//end of if(ndiff)
 
-		Sdts1+=sts1;	Sdts2+=sts2;	Sdtv+=stv;
-		Ndts1+=nts1;	Ndts2+=nts2;	Ndtv+=ntv;
+		diffs[h*NDIFFS+1]=sts1;	diffs[h*NDIFFS+2]=sts2;	diffs[h*NDIFFS+3]=stv;
+		diffs[h*NDIFFS+4]=nts1;	diffs[h*NDIFFS+5]=nts2;	diffs[h*NDIFFS+6]=ntv;
 	}//end of for(h)
+
+	for (h=0; h<counts.positions.size(); h++) {
+		const double *d=&diffs[counts.positions[h]*NDIFFS];
+		snp+=d[0];
+		Sdts1+=d[1];	Sdts2+=d[2];	Sdtv+=d[3];
+		Ndts1+=d[4];	Ndts2+=d[5];	Ndtv+=d[6];
+	}
 	
    return (0);
 }
 
-int MYN::DistanceYN00(const string seq1, const string seq2, double &dS,double &dN, double &SEdS, double &SEdN) {
+int MYN::DistanceYN00(const string &seq1, const string &seq2, double &dS,double &dN, double &SEdS, double &SEdN) {
 
 	int j,ir,nround=100, status=1;
 	double fbS[4], fbN[4], fbSt[4], fbNt[4];
 	double St, Nt, Sdts1, Sdts2, Sdtv, Ndts1, Ndts2, Ndtv;
 	double w0=0, S0=0, N0=0, dS0=0, dN0=0, accu=5e-8, minomega=1e-5, maxomega=99;
 	double PMatrix[CODON*CODON];
+	CodonPairCounts local;
 	
 	//initial values for t and omega(Ka/Ks)
 	t=0.09; 
@@ -503,6 +511,9 @@ int MYN::DistanceYN00(const string seq1, const string seq2, double &dS,double &d
 		fbN[j]+=fbNt[j]/2; 
 	}
 
+	//Pairs of codons, counted once for all rounds
+	const CodonPairCounts &counts = getCodonPairs(seq1, seq2, local);
+
 	//Iterative loop
 	for (ir=0; ir<nround; ir++) {   /* iteration */
 
@@ -510,7 +521,7 @@ int MYN::DistanceYN00(const string seq1, const string seq2, double &dS,double &d
 		GetPMatCodon(PMatrix,kappa,omega);	
 
 		//Count differences
-		CountDiffs(seq1, seq2, Sdts1, Sdts2, Sdtv, Ndts1, Ndts2, Ndtv, PMatrix);
+		CountDiffs(counts, Sdts1, Sdts2, Sdtv, Ndts1, Ndts2, Ndtv, PMatrix);
 
 		//Synonymous(Sd) and nonsynonymous(Nd) differences
 		Sd = Sdts1 + Sdts2 + Sdtv;
@@ -563,33 +574,32 @@ int MYN::DistanceYN00(const string seq1, const string seq2, double &dS,double &d
 
 
 /* Count the synonymous and nonsynonymous sites of two sequences */
-int MYN::CountSites(const string seq, double &Stot, double &Ntot,double fbS[],double fbN[]) {
-	int h,i,j,k, c[2],aa[2], b[3], by[3]={16,4,1};
+int MYN::CountSites(const string &seq, double &Stot, double &Ntot,double fbS[],double fbN[]) {
+	int h,j,k, c[2], b[3], by[3]={16,4,1};
 	double r, S,N;
 	
+	const CodonTable &table = codonTable();
+
 	Stot=Ntot=0;  
 	initArray(fbS, 4);
 	initArray(fbN, 4);
 
-	for (h=0; h<seq.length(); h+=3) {
+	//Sites summed in the order of the codons, as Fisher's test is sensitive to rounding
+	for (h=0; h+3<=seq.length(); h+=3) {
 
-		//Get codon id and amino acid
-		c[0]=getID(seq.substr(h,3));
-		aa[0]=getAminoAcid(c[0]); 		
-		for(i=0; i<3; i++) {
-			b[i]=convertChar(seq[h+i]); 
-		}		
+		//Get codon id
+		c[0]=getID(seq.c_str()+h);
+		b[0]=c[0]/16;
+		b[1]=(c[0]%16)/4;
+		b[2]=c[0]%4;
 
 		for (j=0,S=N=0; j<3; j++) {
 			for(k=0; k<4; k++) {    /* b[j] changes to k */
-				if (k==b[j]) 
+				char change = table.change[c[0]][j][k];
+				if (change==CHANGE_SAME || change==CHANGE_STOP) 
 					continue;
 				//c[0] change at position j
 				c[1] = c[0]+(k-b[j])*by[j];
-				aa[1] = getAminoAcid(c[1]);
-
-				if(aa[1]=='!') 
-					continue;
 				
 				r=pi[c[1]];				
 				if (k+b[j]==1 || k+b[j]==5)	{//transition
@@ -597,7 +607,7 @@ int MYN::CountSites(const string seq, double &Stot, double &Ntot,double fbS[],do
 					else r*=kappaag;	//(k+b[j]==5)
 				}
 				
-				if (aa[0]==aa[1]) { //synonymous
+				if (change==CHANGE_SYN) { //synonymous
 					S+=r;
 					fbS[b[j]]+=r; //syn probability of A,C,G,T					
 				}
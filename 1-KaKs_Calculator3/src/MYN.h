@@ -31,21 +31,21 @@ using namespace std;
 class MYN: public YN00 {
 
 public:
-	MYN();
+	MYN(const Context &c);
 	/* Get the two kappas between purines and between pyrimidines */
-	virtual int GetKappa(const string seq1, const string seq2);	
+	virtual int GetKappa(const string &seq1, const string &seq2);	
 	/* Calculate the transition probability matrix  */
 	int GetPMatCodon(double P[], double kappa, double omega);
 	/* Count S and N */
-	int CountSites(const string z, double &Stot,double &Ntot,double fbS[],double fbN[]);
+	int CountSites(const string &z, double &Stot,double &Ntot,double fbS[],double fbN[]);
 	/* Correct for multiple substitutions for two kappas */
 	int CorrectKappaTN93(double n, double P1, double P2, double Q, double pi4[], double &kappatc_TN93, double &kappaag_TN93);	
 	/* Correct for multiple substitutions for Ka and Ks */
 	int CorrectKaksTN93(double n, double P1, double P2, double Q, double pi4[], double &kaks, double &SEkaks);
 	/* Count Sd and Nd */
-	int CountDiffs(const string seq1, const string seq2, double &Sdts1, double &Sdts2, double &Sdtv,double &Ndts1, double &Ndts2, double &Ndtv,double PMatrix[]);
+	int CountDiffs(const CodonPairCounts &counts, double &Sdts1, double &Sdts2, double &Sdtv,double &Ndts1, double &Ndts2, double &Ndtv,double PMatrix[]);
 	/* Main function */
-	virtual int DistanceYN00(const string seq1, const string seq2, double &dS,double &dN, double &SEdS, double &SEdN); 
+	virtual int DistanceYN00(const string &seq1, const string &seq2, double &dS,double &dN, double &SEdS, double &SEdN); 
 };
 
 
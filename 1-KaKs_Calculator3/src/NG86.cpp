@@ -16,37 +16,25 @@
 
 #include "NG86.h"
 
-NG86::NG86() {
+#include<mutex>
+
+NG86::NG86(const Context &c): Base(c) {
 	name = "NG";	
 }
 
 
 //Count synonymous(S) and nonsynonymous(N) sites
-void NG86::getCondonSite(string codon) {
+void NG86::getCondonSite(int codon) {
 
-	int i,j,stop;
-	string temp="";
-	double syn = 0.0;
-	
-	if (getAminoAcid(codon)=='!')
+	const CodonTable &table = codonTable();
+
+	if (table.aa[codon]=='!')
 		return;
 	
 	/* Synonymous sites only occur at first and third position in a codon */
-	for(i=0, stop=0; i<3; i+=2) {
-		for(j=0; j<4; j++) {
-			temp = codon;
-			if (j!=convertChar(temp[i])) {
-				temp[i] = convertInt(j);
-				if (getAminoAcid(temp)=='!') {
-					stop++;
-				}
-				else {
-					if (getAminoAcid(temp)==getAminoAcid(codon))
-						syn++;
-				}
-			}
-		}
-	}
+	double syn = table.syn[codon][0] + table.syn[codon][2];
+	int stop = table.stop[codon][0] + table.stop[codon][2];
+
 	S += (syn/3.0);
 	N += (3-stop/3.0-syn/3.0);
 }
@@ -157,15 +145,68 @@ void NG86::getCondonDifference(string codon1, string codon2) {
 	
 }
 
-void NG86::PreProcess(string seq1, string seq2) {
+/****************************************************
+* Function: getPairSums
+* Input Parameter: void
+* Output: Count the differences of each pair of codons
+		  alone, the first time the genetic code is used.
+		  NG86 and NONE share the sums.
+* Return Value: vector of PairSums
+*****************************************************/
+const vector<NG86::PairSums> &NG86::getPairSums() {
+
+	static vector<PairSums> tables[NCODE];
+	static once_flag built[NCODE];
+
+	vector<PairSums> &table = tables[ctx.genetic_code-1];
+	call_once(built[ctx.genetic_code-1], [this, &table]() {
+		NG86 ng(ctx);
+		table.resize(CODON*CODON);
+		for (int k=0; k<CODON*CODON; k++) {
+			ng.Sd = ng.Nd = ng.snp = 0;
+			ng.getCondonDifference(getCodon(k/CODON), getCodon(k%CODON));
+
+			PairSums &sums = table[k];
+			sums.Sd = ng.Sd;
+			sums.Nd = ng.Nd;
+			sums.snp = ng.snp;
+		}
+	});
+
+	return table;
+}
+
+void NG86::PreProcess(const string &seq1, const string &seq2) {
 
 	long i;
+
+	//Sites and differences counted by NONE or NG already
+	SharedStages *stages = getStages(seq1, seq2);
+	if (stages!=NULL && stages->ng.done) {
+		S = stages->ng.S;
+		N = stages->ng.N;
+		Sd = stages->ng.Sd;
+		Nd = stages->ng.Nd;
+		snp = stages->ng.snp;
+		return;
+	}
 	
-	//Count sites and differences
+	//Count sites, in the order of codons as the p-value of Fisher's test
+	//is sensitive to the rounding of the sums
 	for(i=0; i<seq1.length(); i=i+3) {
-		getCondonSite(seq1.substr(i,3));
-		getCondonSite(seq2.substr(i,3));
-		getCondonDifference(seq1.substr(i,3), seq2.substr(i,3));
+		getCondonSite(getID(seq1.c_str()+i));
+		getCondonSite(getID(seq2.c_str()+i));
+	}
+
+	//Count differences, looked up by the pairs of codons and added in their order
+	CodonPairCounts local;
+	const CodonPairCounts &counts = getCodonPairs(seq1, seq2, local);
+	const vector<PairSums> &table = getPairSums();
+	for(i=0; i<counts.positions.size(); i++) {
+		const PairSums &sums = table[counts.pairs[counts.positions[i]]];
+		Sd += sums.Sd;
+		Nd += sums.Nd;
+		snp += sums.snp;
 	}
 	
 	S/=2.0;
@@ -175,6 +216,15 @@ void NG86::PreProcess(string seq1, string seq2) {
 	double y=seq1.length()/(S+N); 
 	S*=y;
 	N*=y;
+
+	if (stages!=NULL) {
+		stages->ng.S = S;
+		stages->ng.N = N;
+		stages->ng.Sd = Sd;
+		stages->ng.Nd = Nd;
+		stages->ng.snp = snp;
+		stages->ng.done = true;
+	}
 }
 
 /* Jukes & Cantor's one-parameter formula for correction */
@@ -195,7 +245,7 @@ double NG86::kaks_formula(double p) {
 	return d;
 }
 
-string NG86::Run(string seq1, string seq2) {
+string NG86::Run(const string &seq1, const string &seq2) {
 	
 	PreProcess(seq1, seq2);
 
@@ -213,11 +263,11 @@ string NG86::Run(string seq1, string seq2) {
   NONE: an in-house algorithm for testing Ka and Ks.
   NONE is NG86 without correction for multiple substitutions.
 ************************************************************/
-NONE::NONE() {
+NONE::NONE(const Context &c): NG86(c) {
 	name = "NONE";	
 }
 
-string NONE::Run(string seq1, string seq2) {
+string NONE::Run(const string &seq1, const string &seq2) {
 	
 	PreProcess(seq1, seq2);
 
@@ -26,18 +26,25 @@ using namespace std;
 class NG86: public Base {
 	
 public:
-	NG86();
+	NG86(const Context &c);
 
 	/* Main function of calculating kaks */
-	string Run(string seq1, string seq2);
+	string Run(const string &seq1, const string &seq2);
 
 protected:
-	/* Count codon's sites */
-	void getCondonSite(string codon);
+	/* Differences of a pair of codons */
+	struct PairSums {
+		double Sd, Nd, snp;
+	};
+	/* Differences of each pair of codons (id1*CODON+id2) in the genetic code, built once */
+	const vector<PairSums> &getPairSums();
+
+	/* Count codon's sites, by the codon's id */
+	void getCondonSite(int codon);
 	/* Count codon's differences */
 	void getCondonDifference(string codon1, string codon2);
 	/* Preprocess */
-	void PreProcess(string seq1, string seq2);
+	void PreProcess(const string &seq1, const string &seq2);
 	/* Jukes and Cantor's one-parameter formula */
 	double kaks_formula(double p);
 
@@ -49,9 +56,9 @@ public:
 class NONE: public NG86 {
 
 public:
-	NONE();
+	NONE(const Context &c);
 	/* Main function of calculating kaks */
-	string Run(string seq1, string seq2);
+	string Run(const string &seq1, const string &seq2);
 	
 };
 
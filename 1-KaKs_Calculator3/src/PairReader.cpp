@@ -0,0 +1,195 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: PairReader.cpp
+* Abstract: Definition of a reader of pairs listed by the names
+			of sequences in FASTA file, loaded once into memory
+			and given as records of axt file.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+
+#include "PairReader.h"
+
+/* Trim blanks at both ends, e.g. '\r' of a file from Windows */
+static string_view trim(string_view str) {
+	size_t i = str.find_first_not_of(" \t\r");
+	if (i == string_view::npos) return string_view();
+	return str.substr(i, str.find_last_not_of(" \t\r") - i + 1);
+}
+
+bool SeqStore::add(string_view name, const string &seq) {
+
+	if (ids.find(string(name)) != ids.end()) return false;
+
+	if (starts.size() == 0) starts.push_back(0);
+	ids[string(name)] = starts.size() - 1;
+	seqs += seq;
+	starts.push_back(seqs.length());
+
+	return true;
+}
+
+bool SeqStore::find(string_view name, string_view &seq) const {
+
+	unordered_map<string, size_t>::const_iterator it = ids.find(string(name));
+	if (it == ids.end()) return false;
+
+	seq = string_view(seqs).substr(starts[it->second], starts[it->second + 1] - starts[it->second]);
+	return true;
+}
+
+
+PairReader::PairReader() {
+	msg = name = "";
+}
+
+/****************************************************
+* Function: open
+* Input Parameter: string, string
+* Output: Load the sequences of FASTA file, then open the
+		  list of pairs as the file read by 'next'.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool PairReader::open(string fasta_filename, string list_filename) {
+
+	if (!loadFASTA(fasta_filename)) return false;
+
+	return AXTReader::open(list_filename);
+}
+
+/****************************************************
+* Function: loadFASTA
+* Input Parameter: string
+* Output: Read each sequence, joining its lines, into the
+		  store by the first word of its name line. Of the
+		  sequences with the same name, the first is kept.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool PairReader::loadFASTA(string filename) {
+
+	bool flag = true;
+
+	try {
+		PairReader fasta;
+		if (!fasta.AXTReader::open(filename)) throw 1;
+
+		store = SeqStore();
+
+		string seq = "", seq_name = "";
+		bool named = false;
+		unsigned long duplicates = 0;
+		string_view line;
+		while (true) {
+			bool more = fasta.getLine(line);
+			line = trim(line);
+			if (!more || (line.length() > 0 && line[0] == '>')) {
+				if (named && !store.add(seq_name, seq)) duplicates++;
+				if (!more) break;
+
+				line = trim(line.substr(1));
+				seq_name = string(line.substr(0, line.find_first_of(" \t")));
+				seq = "";
+				named = true;
+			}
+			else if (named) {
+				seq.append(line.data(), line.length());
+			}
+			fasta.release();
+		}
+		if (fasta.isFailed()) throw 1;
+		if (duplicates > 0) cout << "Warning: " << duplicates << " sequences with a name used before are ignored." << endl;
+	}
+	catch (...) {
+		cout << "Error in reading FASTA file: " << filename << endl;
+		flag = false;
+	}
+
+	return flag;
+}
+
+bool PairReader::getPairLine(string_view &line) {
+
+	while (getLine(line)) {
+		line = trim(line);
+		if (line.length() > 0 && line[0] != '#') return true;
+	}
+
+	return false;
+}
+
+/****************************************************
+* Function: next
+* Input Parameter: AXTRecord
+* Output: Read a line of two names, giving the sequences
+		  as the two lines of a record.
+* Return Value: True if a pair is read, otherwise false.
+*****************************************************/
+bool PairReader::next(AXTRecord &rec) {
+
+	rec.lines.clear();
+	rec.length = 0;
+	rec.kept = true;
+	msg = "";
+
+	release();
+	string_view line;
+	if (!getPairLine(line)) return false;
+	rec.end = pos;
+
+	size_t i = line.find_first_of(" \t");
+	string_view name1 = line.substr(0, i), name2;
+	if (i != string_view::npos) {
+		name2 = trim(line.substr(i));
+		name2 = name2.substr(0, name2.find_first_of(" \t"));
+	}
+	name = string(name1) + "&" + string(name2);
+	rec.name = name;
+
+	string_view seq1, seq2;
+	if (name2.length() == 0) {
+		msg = "[Error. Two names are needed for the pair " + string(line) + ".]";
+	}
+	else if (!store.find(name1, seq1)) {
+		msg = "[Error. No sequence named " + string(name1) + " for the pair " + name + ".]";
+	}
+	else if (!store.find(name2, seq2)) {
+		msg = "[Error. No sequence named " + string(name2) + " for the pair " + name + ".]";
+	}
+	else if (seq1.length() != seq2.length()) {
+		msg = "[Error. The sequences are not equal in length.]";
+	}
+	else {
+		rec.lines.push_back(seq1);
+		rec.lines.push_back(seq2);
+		rec.length = seq1.length() + seq2.length();
+	}
+
+	return true;
+}
+
+/****************************************************
+* Function: index
+* Input Parameter: AXTIndex
+* Output: Scan the list for the offset of each pair, then
+		  go back to the current offset.
+* Return Value: True if succeed, otherwise false.
+*****************************************************/
+bool PairReader::index(AXTIndex &idx) {
+
+	size_t current = pos;
+	idx.offsets.clear();
+	idx.file_size = size;
+
+	AXTReader::seek(0);
+	string_view line;
+	while (getPairLine(line)) {
+		idx.offsets.push_back(line.data() - data);
+		release();
+	}
+	AXTReader::seek(current);
+
+	return !isFailed();
+}
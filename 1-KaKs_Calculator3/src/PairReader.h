@@ -0,0 +1,72 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: PairReader.h
+* Abstract: Declaration of a reader of pairs listed by the names
+			of sequences in FASTA file, loaded once into memory
+			and given as records of axt file.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+#if !defined(PAIRREADER_H)
+#define  PAIRREADER_H
+
+#include<string>
+#include<string_view>
+#include<vector>
+#include<unordered_map>
+
+#include "AXTReader.h"
+#include "AXTIndex.h"
+
+using namespace std;
+
+/* Sequences of FASTA file, one after the other in a string */
+struct SeqStore {
+	/* All sequences joined */
+	string seqs;
+	/* Offset of each sequence in 'seqs', and the end of the last one */
+	vector<size_t> starts;
+	/* Index of each sequence by its name */
+	unordered_map<string, size_t> ids;
+
+	/* Add a sequence, unless one of the name was added before */
+	bool add(string_view name, const string &seq);
+	/* Get the sequence of a name, false if not found */
+	bool find(string_view name, string_view &seq) const;
+};
+
+/* Pairs in a list file of two names on each line, read as records whose
+   two lines are views into the sequences stored. A line of the list is
+   a record, so that the offsets of the list serve for --shard, --records
+   and checkpoints as those of axt file */
+class PairReader: public AXTReader {
+
+public:
+	PairReader();
+
+	/* Load the sequences of FASTA file, and open the list of pairs */
+	bool open(string fasta_filename, string list_filename);
+	/* Get the next pair named "name1&name2", false at the end of list.
+	   A pair not found in FASTA file has no lines, and 'msg' tells why */
+	bool next(AXTRecord &rec);
+	/* Scan the list for the offset of each pair */
+	bool index(AXTIndex &idx);
+
+	/* Error message of the last pair, empty if both sequences are found */
+	string msg;
+
+protected:
+	/* Read FASTA file, maybe gzip, into the store */
+	bool loadFASTA(string filename);
+	/* Get the next line naming a pair, skipping blank and comment lines */
+	bool getPairLine(string_view &line);
+
+	SeqStore store;
+	/* Name of the last pair, viewed by the record */
+	string name;
+};
+
+#endif
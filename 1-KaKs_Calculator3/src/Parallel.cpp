@@ -0,0 +1,148 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: Parallel.cpp
+* Abstract: Definition of a process-wide thread pool running
+			groups of tasks, used to calculate pairs in parallel.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+
+#include "Parallel.h"
+
+/******** The process-wide pool ********/
+static mutex pool_lock;
+static condition_variable pool_ready;
+/* One entry per queued task by decreasing cost, pointing to the group owning it */
+static multimap< double, shared_ptr<TaskGroup::State>, greater<double> > pool_queue;
+static vector<thread> pool_threads;
+static bool pool_stop = false;
+
+/* Stop and join the threads when the program exits */
+static struct PoolGuard {
+	~PoolGuard() {
+		TaskGroup::setThreads(1);
+	}
+} pool_guard;
+//********End of the pool**********
+
+TaskGroup::TaskGroup() {
+	state = shared_ptr<State>(new State());
+}
+
+TaskGroup::~TaskGroup() {
+	wait();
+}
+
+/********************************************
+* Function: setThreads
+* Input Parameter: int
+* Output: Start n threads of the pool, or none
+		  for n<=1 so that tasks run serially.
+* Return Value: void
+*********************************************/
+void TaskGroup::setThreads(int n) {
+
+	int i;
+
+	//Stop the running threads first
+	{
+		lock_guard<mutex> lk(pool_lock);
+		pool_stop = true;
+	}
+	pool_ready.notify_all();
+	for (i = 0; i < pool_threads.size(); i++) pool_threads[i].join();
+	pool_threads.clear();
+
+	lock_guard<mutex> lk(pool_lock);
+	pool_stop = false;
+	for (i = 0; n > 1 && i < n; i++) pool_threads.push_back(thread(workerLoop));
+}
+
+int TaskGroup::getThreads() {
+	lock_guard<mutex> lk(pool_lock);
+	return pool_threads.size() > 0 ? pool_threads.size() : 1;
+}
+
+/********************************************
+* Function: run
+* Input Parameter: function, double
+* Output: Queue the task on the pool. The most costly
+		  tasks are started first, so that large ones
+		  do not hold up the end of a run.
+* Return Value: void
+*********************************************/
+void TaskGroup::run(function<void()> task, double cost) {
+
+	if (getThreads() <= 1) {
+		task();
+		return;
+	}
+
+	{
+		lock_guard<mutex> lk(state->lock);
+		state->tasks.insert(make_pair(cost, task));
+		state->pending++;
+	}
+	{
+		lock_guard<mutex> lk(pool_lock);
+		pool_queue.insert(make_pair(cost, state));
+	}
+	pool_ready.notify_one();
+}
+
+/********************************************
+* Function: wait
+* Input Parameter: void
+* Output: Wait until all tasks of the group finish.
+		  The caller runs the tasks not yet started,
+		  so nested groups never leave it idle.
+* Return Value: void
+*********************************************/
+void TaskGroup::wait() {
+
+	while (runOne(state));
+
+	unique_lock<mutex> lk(state->lock);
+	while (state->pending > 0) state->finished.wait(lk);
+}
+
+bool TaskGroup::runOne(shared_ptr<State> s) {
+
+	function<void()> task;
+	{
+		lock_guard<mutex> lk(s->lock);
+		if (s->tasks.empty()) return false;
+		task = s->tasks.begin()->second;
+		s->tasks.erase(s->tasks.begin());
+	}
+
+	try {
+		task();
+	}
+	catch (...) {
+	}
+
+	lock_guard<mutex> lk(s->lock);
+	if (--s->pending == 0) s->finished.notify_all();
+
+	return true;
+}
+
+void TaskGroup::workerLoop() {
+
+	while (true) {
+		shared_ptr<State> s;
+		{
+			unique_lock<mutex> lk(pool_lock);
+			while (!pool_stop && pool_queue.empty()) pool_ready.wait(lk);
+			if (pool_queue.empty()) return;
+			s = pool_queue.begin()->second;
+			pool_queue.erase(pool_queue.begin());
+		}
+		//The task may have been run by a waiting owner already
+		runOne(s);
+	}
+}
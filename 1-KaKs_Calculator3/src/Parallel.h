@@ -0,0 +1,110 @@
+/************************************************************
+* Copyright (c) CNCB-NGDC, BIG, CAS
+* All rights reserved.
+
+* Filename: Parallel.h
+* Abstract: Declaration of a process-wide thread pool running
+			groups of tasks, used to calculate pairs in parallel.
+
+* Version: 3.0
+* Date: Oct.17, 2026
+*************************************************************/
+#if !defined(PARALLEL_H)
+#define  PARALLEL_H
+
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<functional>
+#include<deque>
+#include<map>
+#include<memory>
+#include<vector>
+
+using namespace std;
+
+/* A group of tasks queued on the process-wide pool and waited for together */
+class TaskGroup {
+
+public:
+	TaskGroup();
+	~TaskGroup();
+
+	/* Queue a task, or run it at once if the pool has no thread.
+	   Tasks of higher cost are started first, others in order */
+	void run(function<void()> task, double cost=0.0);
+	/* Wait for all tasks of the group, running the queued ones meanwhile */
+	void wait();
+
+	/* Set the number of threads of the pool, 1 for running serially */
+	static void setThreads(int n);
+	/* Get the number of threads of the pool */
+	static int getThreads();
+
+public:
+	/* Shared by the group and its entries queued on the pool */
+	struct State {
+		State(): pending(0) {}
+
+		mutex lock;
+		condition_variable finished;
+		/* Tasks not yet started, by decreasing cost */
+		multimap< double, function<void()>, greater<double> > tasks;
+		/* Tasks not yet finished */
+		int pending;
+	};
+
+protected:
+	/* Run one task of the group if any is left, return false otherwise */
+	static bool runOne(shared_ptr<State> s);
+	/* Main loop of the threads of the pool */
+	static void workerLoop();
+
+	shared_ptr<State> state;
+};
+
+/* A queue of bounded size connecting two stages of a pipeline */
+template<class T>
+class BoundedQueue {
+
+public:
+	BoundedQueue(size_t n): capacity(n>0?n:1), closed(false) {}
+
+	/* Put an item, waiting while the queue is full; false if the queue is closed */
+	bool push(T item) {
+		unique_lock<mutex> lk(lock);
+		while (!closed && items.size() >= capacity) notFull.wait(lk);
+		if (closed) return false;
+		items.push_back(item);
+		notEmpty.notify_one();
+		return true;
+	}
+
+	/* Take an item, waiting while the queue is empty; false if closed and empty */
+	bool pop(T &item) {
+		unique_lock<mutex> lk(lock);
+		while (!closed && items.empty()) notEmpty.wait(lk);
+		if (items.empty()) return false;
+		item = items.front();
+		items.pop_front();
+		notFull.notify_one();
+		return true;
+	}
+
+	/* No more items are put, the waiting stages are woken up */
+	void close() {
+		lock_guard<mutex> lk(lock);
+		closed = true;
+		notFull.notify_all();
+		notEmpty.notify_all();
+	}
+
+protected:
+	mutex lock;
+	condition_variable notFull, notEmpty;
+	deque<T> items;
+	size_t capacity;
+	bool closed;
+};
+
+#endif
@@ -24,7 +24,7 @@
 #include "YN00.h"
 
 
-YN00::YN00() {
+YN00::YN00(const Context &c): Base(c) {
 
 	name = "YN";
 	initArray(f12pos, 12);
@@ -32,11 +32,21 @@ YN00::YN00() {
 	iteration = 1;
 }
 
-void YN00::getFreqency(const string seq1, const string seq2) {
+void YN00::getFreqency(const string &seq1, const string &seq2) {
 	
 	int i;
 	double fstop=0.0;
 
+	//Frequencies got by YN or MYN already
+	SharedStages *stages = getStages(seq1, seq2);
+	if (stages!=NULL && stages->yn.done) {
+		copyArray(stages->yn.f12pos, f12pos, CODONFREQ);
+		copyArray(stages->yn.pi, pi, CODON);
+		copyArray(stages->yn.pi_sqrt, pi_sqrt, CODON-stages->yn.npi0);
+		npi0 = stages->yn.npi0;
+		return;
+	}
+
 	//Get A,C,G,T frequency at three positions
 	for(i=0; i<seq1.length(); i++) {
 		f12pos[(i%3)*4+convertChar(seq1[i])]++;			
@@ -65,17 +75,26 @@ void YN00::getFreqency(const string seq1, const string seq2) {
 			pi_sqrt[npi0++]=sqrt(pi[i]);
 	
 	npi0=CODON-npi0;
-	
+
+	if (stages!=NULL) {
+		copyArray(f12pos, stages->yn.f12pos, CODONFREQ);
+		copyArray(pi, stages->yn.pi, CODON);
+		copyArray(pi_sqrt, stages->yn.pi_sqrt, CODON-npi0);
+		stages->yn.npi0 = npi0;
+		stages->yn.done = true;
+	}
 }
 
 
 /* Estimate kappa using the fourfold degenerate sites at third codon positions and nondegenerate sites */
-int YN00::GetKappa(const string seq1, const string seq2) {
+int YN00::GetKappa(const string &seq1, const string &seq2) {
 
-	int i,j,k,h,pos,c[2],aa[2],b[2][3],nondeg,fourdeg,by[3]={16,4,1};
+	int j,k,h,pos,c[2],aa[2],b[2][3],nondeg,fourdeg;
 	double ka[2], F[2][XSIZE],S[2],wk[2], T,V, pi4[4];
 	double kdefault=2, nullValue=NULL, t;
 		
+	const CodonTable &table = codonTable();
+
 	for(k=0; k<2; k++)
 		initArray(F[k],16);
 	
@@ -83,11 +102,11 @@ int YN00::GetKappa(const string seq1, const string seq2) {
 	for(h=0; h<seq1.length(); h+=3) {
 		
 		//c[]: amino acid(0--63)
-		c[0]=getID(seq1.substr(h,3));
-		c[1]=getID(seq2.substr(h,3));
+		c[0]=getID(seq1.c_str()+h);
+		c[1]=getID(seq2.c_str()+h);
 		//aa[ ]: amino acid
-		aa[0]=getAminoAcid(c[0]);
-		aa[1]=getAminoAcid(c[1]);		
+		aa[0]=table.aa[c[0]];
+		aa[1]=table.aa[c[1]];		
 		//b[][]: 0--3
 		for(j=0; j<3; j++) {
 			b[0][j] = convertChar(seq1[h+j]);
@@ -97,12 +116,7 @@ int YN00::GetKappa(const string seq1, const string seq2) {
 		//Find non-degenerate sites
 		for(pos=0; pos<3; pos++) {        
 			for(k=0,nondeg=0; k<2; k++) {
-				for(i=0; i<4; i++) {
-					if(i!=b[k][pos]) 						
-						if (getAminoAcid(c[k]+(i-b[k][pos])*by[pos])==aa[k]) 
-							break;					
-				}
-				if (i==4) 
+				if (table.nondegenerate[c[k]][pos]) 
 					nondeg++;
 			}
 			//F[0][]: 0-fold
@@ -114,10 +128,7 @@ int YN00::GetKappa(const string seq1, const string seq2) {
 		
 		//Find 4-fold degenerate sites at 3rd position
 		for(k=0,fourdeg=0;k<2;k++) {
-			for(j=0,i=c[k]-b[k][2]; j<4; j++) 
-				if(j!=b[k][2] && getAminoAcid(i+j)!=aa[k])
-					break;
-			if(aa[0]==aa[1] && j==4)
+			if(aa[0]==aa[1] && table.fourfold[c[k]])
 				fourdeg++;
 		}
 		//F[1][]: 4-fold
@@ -259,12 +270,13 @@ int YN00::DistanceF84(double n, double P, double Q, double pi4[], double &k_HKY,
 	return(failF84 + failK80 + failJC69);
 }
 
-int YN00::DistanceYN00(const string seq1, const string seq2, double &dS,double &dN, double &SEKs, double &SEKa) {
+int YN00::DistanceYN00(const string &seq1, const string &seq2, double &dS,double &dN, double &SEKs, double &SEKa) {
 
 	int j,k,ir,nround=10, status=0;
 	double fbS[4], fbN[4], fbSt[4], fbNt[4], St, Nt, Sdts, Sdtv, Ndts, Ndtv, k_HKY;
 	double w0=0, dS0=0, dN0=0, accu=5e-4, minomega=1e-5, maxomega=99;
 	double PMatrix[CODON*CODON];
+	CodonPairCounts local;
 	
 	if(t==0)
 		t=.5;  
@@ -296,6 +308,8 @@ int YN00::DistanceYN00(const string seq1, const string seq2, double &dS,double &
 	if (omega<0.01 || omega>5)
 		omega=.5;
 
+	//Pairs of codons, counted once for all rounds
+	const CodonPairCounts &counts = getCodonPairs(seq1, seq2, local);
 	
 	for (ir=0; ir<(iteration?nround:1); ir++) {   /* iteration */
 		if(iteration) 
@@ -305,7 +319,7 @@ int YN00::DistanceYN00(const string seq1, const string seq2, double &dS,double &
 				PMatrix[j]=1;
 			}
 		
-		CountDiffs(seq1,seq2, Sdts, Sdtv, Ndts, Ndtv, PMatrix);
+		CountDiffs(counts, Sdts, Sdtv, Ndts, Ndtv, PMatrix);
 		
 		Sd = Sdts + Sdtv;
 		Nd = Ndts + Ndtv;
@@ -341,7 +355,7 @@ int YN00::DistanceYN00(const string seq1, const string seq2, double &dS,double &
 }
 
 //Count differences between two compared codons
-int YN00::CountDiffs(const string seq1, const string seq2, double &Sdts,double &Sdtv,double &Ndts, double &Ndtv,double PMatrix[]) {
+int YN00::CountDiffs(const CodonPairCounts &counts, double &Sdts,double &Sdtv,double &Ndts, double &Ndtv,double PMatrix[]) {
 	int h,i1,i2,i,k, transi, c[2],ct[2], by[3]={16,4,1};
 	char aa[2];
 	int dmark[3], step[3], b[2][3], bt1[3], bt2[3];
@@ -349,11 +363,17 @@ int YN00::CountDiffs(const string seq1, const string seq2, double &Sdts,double &
 	double sts,stv,nts,ntv; /* syn ts & tv, nonsyn ts & tv for 2 codons */
 	double ppath[6], sump,p;
 
+	//Differences of each pair of codons, summed in the order of the codons
+	//as Fisher's test is sensitive to rounding: ndiff, sts, stv, nts, ntv
+	const int NDIFFS=5;
+	vector<double> diffs(counts.pairs.size()*NDIFFS, 0.0);
+
 	snp = 0;
-	for (h=0,Sdts=Sdtv=Ndts=Ndtv=0; h<seq1.length(); h+=3)  {		
+	for (h=0,Sdts=Sdtv=Ndts=Ndtv=0; h<counts.pairs.size(); h++)  {		
 
-		c[0]=getID(seq1.substr(h,3));
-		c[1]=getID(seq2.substr(h,3));
+		//Each pair of codons once
+		c[0]=counts.pairs[h]/CODON;
+		c[1]=counts.pairs[h]%CODON;
 		//Difference?
 		if (c[0]==c[1])
 			continue;
@@ -375,7 +395,7 @@ int YN00::CountDiffs(const string seq1, const string seq2, double &Sdts,double &
 				dmark[ndiff++]=k;
 		}
 
-		snp+=ndiff;
+		diffs[h*NDIFFS]=ndiff;
 
 		npath=1;
 		if(ndiff>1)
@@ -487,12 +507,21 @@ int YN00::CountDiffs(const string seq1, const string seq2, double &Sdts,double &
 			}			
 			
 		}//end of if(ndiff)
-		Sdts+=sts;
-		Sdtv+=stv;
-		Ndts+=nts;
-		Ndtv+=ntv;
+		diffs[h*NDIFFS+1]=sts;
+		diffs[h*NDIFFS+2]=stv;
+		diffs[h*NDIFFS+3]=nts;
+		diffs[h*NDIFFS+4]=ntv;
 
 	}//end of for(h)
+
+	for (h=0; h<counts.positions.size(); h++) {
+		const double *d=&diffs[counts.positions[h]*NDIFFS];
+		snp+=d[0];
+		Sdts+=d[1];
+		Sdtv+=d[2];
+		Ndts+=d[3];
+		Ndtv+=d[4];
+	}
 	
    return (0);
 }
@@ -595,39 +624,38 @@ int YN00::PMatUVRoot (double P[], double t, int n, double U[], double V[], doubl
 
 
 /* Count the synonymous and nonsynonymous sites of two sequences */
-int YN00::CountSites(const string seq, double &Stot, double &Ntot,double fbS[],double fbN[]) {
-	int h,i,j,k, c[2],aa[2], b[3], by[3]={16,4,1};
+int YN00::CountSites(const string &seq, double &Stot, double &Ntot,double fbS[],double fbN[]) {
+	int h,j,k, c[2], b[3], by[3]={16,4,1};
 	double r, S,N;
 	
+	const CodonTable &table = codonTable();
+
 	Stot=Ntot=0;  
 	initArray(fbS, 4);
 	initArray(fbN, 4);
 
-	for (h=0; h<seq.length(); h+=3) {
+	//Sites summed in the order of the codons, as Fisher's test is sensitive to rounding
+	for (h=0; h+3<=seq.length(); h+=3) {
 
-		//Get codon id and amino acid
-		c[0]=getID(seq.substr(h,3));
-		aa[0]=getAminoAcid(c[0]); 		
-		for(i=0; i<3; i++) {
-			b[i]=convertChar(seq[h+i]); 
-		}		
+		//Get codon id
+		c[0]=getID(seq.c_str()+h);
+		b[0]=c[0]/16;
+		b[1]=(c[0]%16)/4;
+		b[2]=c[0]%4;
 
 		for (j=0,S=N=0; j<3; j++) {
 			for(k=0; k<4; k++) {    /* b[j] changes to k */
-				if (k==b[j]) 
+				char change = table.change[c[0]][j][k];
+				if (change==CHANGE_SAME || change==CHANGE_STOP) 
 					continue;
 				//c[0] change at position j
 				c[1] = c[0]+(k-b[j])*by[j];
-				aa[1] = getAminoAcid(c[1]);
-
-				if(aa[1]=='!') 
-					continue;
 				
 				r=pi[c[1]];				
 				if (k+b[j]==1 || k+b[j]==5)	//transition
 					r*=kappa;
 				
-				if (aa[0]==aa[1]) { //synonymous
+				if (change==CHANGE_SYN) { //synonymous
 					S+=r;
 					fbS[b[j]]+=r; //syn probability of A,C,G,T					
 				}
@@ -660,7 +688,7 @@ int YN00::CountSites(const string seq, double &Stot, double &Ntot,double fbS[],d
 }
 
 
-string YN00::Run(string seq1, string seq2) {	
+string YN00::Run(const string &seq1, const string &seq2) {	
 
 	t=0.4; 
 	kappa = NA;
@@ -33,26 +33,26 @@ using namespace std;
 class YN00: public Base {
 
 public:
-	YN00();	
+	YN00(const Context &c);	
 
 	/* Main function of calculating kaks */
-	string Run(string seq1, string seq2);
+	string Run(const string &seq1, const string &seq2);
 	
 //protected:
 	/* Get A,C,G,T's frequency between pair sequences: f12pos[], pi[], pi_sqrt[]  */
-	void getFreqency(const string seq1, const string seq2);
+	void getFreqency(const string &seq1, const string &seq2);
 	/* Get the k(transition/transversion) */
-	virtual int GetKappa(const string seq1, const string seq2);
+	virtual int GetKappa(const string &seq1, const string &seq2);
 	/* Use the HKY85 Model to correct for multiple substitutions */
 	virtual int DistanceF84(double n, double P, double Q, double pi4[],double &k_HKY, double &t, double &SEt);
 	/* Calculate the ka,ks */
-	virtual int DistanceYN00(const string seq1, const string seq2, double &dS,double &dN, double &SEdS, double &SEdN);
+	virtual int DistanceYN00(const string &seq1, const string &seq2, double &dS,double &dN, double &SEdS, double &SEdN);
 	/* Count synonymous and nonsynonmous sites: S, N */
-	virtual int CountSites(const string z, double &Stot,double &Ntot,double fbS[],double fbN[]);
+	virtual int CountSites(const string &z, double &Stot,double &Ntot,double fbS[],double fbN[]);
 	/* Calculate the transition probability matrix using 'kappa' and 'omega' */
 	virtual int GetPMatCodon(double P[], double kappa, double omega);
 	/* Count synonymous and nonsynonmous differences: Sd, Nd */	
-	virtual int CountDiffs(const string seq1, const string seq2, double &Sdts,double &Sdtv,double &Ndts, double &Ndtv,double PMatrix[]);
+	virtual int CountDiffs(const CodonPairCounts &counts, double &Sdts,double &Sdtv,double &Ndts, double &Ndtv,double PMatrix[]);
 	
 	//The following is for calculation of transition probability matrix by Taylor equation
 	int eigenQREV (double Q[], double pi[], double pi_sqrt[], int n, int npi0, double Root[], double U[], double V[]);
@@ -12,13 +12,15 @@
 *************************************************************/
 
 #include "base.h"
+#include "AXTReader.h"
+
+#include<mutex>
 
 
 /******** Global variables ********/
 /*						The Genetic Codes 
 http://www.ncbi.nlm.nih.gov/Taxonomy/Utils/wprintgc.cgi?mode=c
 	Last update of the Genetic Codes: Jan 28, 2021 */
-int genetic_code=1; //from 1 to 33
 /* Genetic standard codon table, !=stop codon */
 const char* transl_table[] = {
  "FFLLSSSSYY!!CC!WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG", "1-Standard Code",
@@ -55,98 +57,87 @@ const char* transl_table[] = {
  "", "32-",
  "FFLLSSSSYYY!CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSSKVVVVAAAADDEEGGGG", "33-Cephalodiscidae Mitochondrial UAA-Tyr Code"
 };
-
-string seq_name;		//sequences' name
-unsigned long length;	//sequences' length
-double GC[4];			//GC Content
 //********End of Global variables**********
 
-//Constructor function
-Base::Base() {
-
-	//Codons
-	int i, id = 0;
-    string nuc = "TCAG";
-	for (i=0; i<64; i++) {
-            ID2Codon[i] = getCodon(i);
-        }
-            
-	IntString::iterator pos;
-	for(pos=ID2Codon.begin(); pos!=ID2Codon.end(); pos++) {
-		//cout<<pos->first << " "<<pos->second<<endl;
-		Codon2ID[pos->second] = pos->first;
+/* Codons in the order of their ids, T, C, A, G as 0~3 */
+const char Base::ID2Codon[CODON][4] = {
+	"TTT", "TTC", "TTA", "TTG", "TCT", "TCC", "TCA", "TCG",
+	"TAT", "TAC", "TAA", "TAG", "TGT", "TGC", "TGA", "TGG",
+	"CTT", "CTC", "CTA", "CTG", "CCT", "CCC", "CCA", "CCG",
+	"CAT", "CAC", "CAA", "CAG", "CGT", "CGC", "CGA", "CGG",
+	"ATT", "ATC", "ATA", "ATG", "ACT", "ACC", "ACA", "ACG",
+	"AAT", "AAC", "AAA", "AAG", "AGT", "AGC", "AGA", "AGG",
+	"GTT", "GTC", "GTA", "GTG", "GCT", "GCC", "GCA", "GCG",
+	"GAT", "GAC", "GAA", "GAG", "GGT", "GGC", "GGA", "GGG",
+};
+
+/* Robustness or Diversity, and Quarter Location of the codons by id */
+const Codon Base::Codon64[CODON] = {
+	{'D', '1'}, {'D', '1'}, {'D', '1'}, {'D', '1'},	//TTT TTC TTA TTG
+	{'R', '3'}, {'R', '3'}, {'R', '3'}, {'R', '3'},	//TCT TCC TCA TCG
+	{'D', '1'}, {'D', '1'}, {'D', '1'}, {'D', '1'},	//TAT TAC TAA TAG
+	{'D', '3'}, {'D', '3'}, {'D', '3'}, {'D', '3'},	//TGT TGC TGA TGG
+	{'R', '2'}, {'R', '2'}, {'R', '2'}, {'R', '2'},	//CTT CTC CTA CTG
+	{'R', '4'}, {'R', '4'}, {'R', '4'}, {'R', '4'},	//CCT CCC CCA CCG
+	{'D', '2'}, {'D', '2'}, {'D', '2'}, {'D', '2'},	//CAT CAC CAA CAG
+	{'R', '4'}, {'R', '4'}, {'R', '4'}, {'R', '4'},	//CGT CGC CGA CGG
+	{'D', '1'}, {'D', '1'}, {'D', '1'}, {'D', '1'},	//ATT ATC ATA ATG
+	{'R', '3'}, {'R', '3'}, {'R', '3'}, {'R', '3'},	//ACT ACC ACA ACG
+	{'D', '1'}, {'D', '1'}, {'D', '1'}, {'D', '1'},	//AAT AAC AAA AAG
+	{'D', '3'}, {'D', '3'}, {'D', '3'}, {'D', '3'},	//AGT AGC AGA AGG
+	{'R', '2'}, {'R', '2'}, {'R', '2'}, {'R', '2'},	//GTT GTC GTA GTG
+	{'R', '4'}, {'R', '4'}, {'R', '4'}, {'R', '4'},	//GCT GCC GCA GCG
+	{'D', '2'}, {'D', '2'}, {'D', '2'}, {'D', '2'},	//GAT GAC GAA GAG
+	{'R', '4'}, {'R', '4'}, {'R', '4'}, {'R', '4'},	//GGT GGC GGA GGG
+};
+
+/****************************************************
+* Function: build
+* Input Parameter: int
+* Output: Change each codon at each position into the other
+		  bases, recording whether the change is synonymous,
+		  nonsynonymous or into a stop codon, and the classes
+		  of degeneracy by the changes.
+* Return Value: void
+*****************************************************/
+void CodonTable::build(int genetic_code) {
+
+	const char *code = transl_table[2*(genetic_code-1)];
+	int by[CODONLENGTH] = {16, 4, 1};
+	int i, pos, k, b, same;
+
+	for (i=0; i<CODON; i++) aa[i] = code[i];
+
+	for (i=0; i<CODON; i++) {
+		for (pos=0; pos<CODONLENGTH; pos++) {
+			b = (i/by[pos])%DNASIZE;
+			syn[i][pos] = stop[i][pos] = same = 0;
+			for (k=0; k<DNASIZE; k++) {
+				char aa2 = aa[i+(k-b)*by[pos]];
+				if (k==b) change[i][pos][k] = CHANGE_SAME;
+				else if (aa2=='!') change[i][pos][k] = CHANGE_STOP;
+				else if (aa2==aa[i]) change[i][pos][k] = CHANGE_SYN;
+				else change[i][pos][k] = CHANGE_NONSYN;
+
+				if (change[i][pos][k]==CHANGE_SYN) syn[i][pos]++;
+				if (change[i][pos][k]==CHANGE_STOP) stop[i][pos]++;
+				//As YN00, a stop codon is the same amino acid as another one
+				if (k!=b && aa2==aa[i]) same++;
+			}
+			fold[i][pos] = syn[i][pos]==0 ? 0 : (syn[i][pos]<3 ? 2 : 4);
+			nondegenerate[i][pos] = (same==0);
+			if (pos==2) fourfold[i] = (same==3);
+		}
 	}
-        
-        //Codons & Genetic Codes
-	Codon64["AAA"] = Codon("D", "1", "KKKKKK!!NKKKKNKK!!!!NKK");
-	Codon64["AAG"] = Codon("D", "1", "KKKKKK!!KKKKKKKK!!!!KKK");
-	Codon64["AAT"] = Codon("D", "1", "NNNNNN!!NNNNNNNN!!!!NNN");
-	Codon64["AAC"] = Codon("D", "1", "NNNNNN!!NNNNNNNN!!!!NNN");
-	Codon64["TAA"] = Codon("D", "1", "*****Q!!*****Y**!!!!***");
-	Codon64["TAG"] = Codon("D", "1", "*****Q!!******QL!!!!*L*");
-	Codon64["TAT"] = Codon("D", "1", "YYYYYY!!YYYYYYYY!!!!YYY");
-	Codon64["TAC"] = Codon("D", "1", "YYYYYY!!YYYYYYYY!!!!YYY");
-	Codon64["ATA"] = Codon("D", "1", "IMMIMI!!IIIIMIII!!!!MII");
-	Codon64["ATG"] = Codon("D", "1", "MMMMMM!!MMMMMMMM!!!!MMM");
-	Codon64["ATT"] = Codon("D", "1", "IIIIII!!IIIIIIII!!!!III");
-	Codon64["ATC"] = Codon("D", "1", "IIIIII!!IIIIIIII!!!!III");
-	Codon64["TTA"] = Codon("D", "1", "LLLLLL!!LLLLLLLL!!!!LL*");
-	Codon64["TTG"] = Codon("D", "1", "LLLLLL!!LLLLLLLL!!!!LLL");
-	Codon64["TTT"] = Codon("D", "1", "FFFFFF!!FFFFFFFF!!!!FFF");
-	Codon64["TTC"] = Codon("D", "1", "FFFFFF!!FFFFFFFF!!!!FFF");
-
-	Codon64["GAA"] = Codon("D", "2", "EEEEEE!!EEEEEEEE!!!!EEE");
-	Codon64["GAG"] = Codon("D", "2", "EEEEEE!!EEEEEEEE!!!!EEE");
-	Codon64["GAT"] = Codon("D", "2", "DDDDDD!!DDDDDDDD!!!!DDD");
-	Codon64["GAC"] = Codon("D", "2", "DDDDDD!!DDDDDDDD!!!!DDD");
-	Codon64["CAA"] = Codon("D", "2", "QQQQQQ!!QQQQQQQQ!!!!QQQ");
-	Codon64["CAG"] = Codon("D", "2", "QQQQQQ!!QQQQQQQQ!!!!QQQ");
-	Codon64["CAT"] = Codon("D", "2", "HHHHHH!!HHHHHHHH!!!!HHH");
-	Codon64["CAC"] = Codon("D", "2", "HHHHHH!!HHHHHHHH!!!!HHH");
-	Codon64["GTA"] = Codon("R", "2", "VVVVVV!!VVVVVVVV!!!!VVV");
-	Codon64["GTG"] = Codon("R", "2", "VVVVVV!!VVVVVVVV!!!!VVV");
-	Codon64["GTT"] = Codon("R", "2", "VVVVVV!!VVVVVVVV!!!!VVV");
-	Codon64["GTC"] = Codon("R", "2", "VVVVVV!!VVVVVVVV!!!!VVV");
-	Codon64["CTA"] = Codon("R", "2", "LLTLLL!!LLLLLLLL!!!!LLL");
-	Codon64["CTG"] = Codon("R", "2", "LLTLLL!!LLLSLLLL!!!!LLL");
-	Codon64["CTT"] = Codon("R", "2", "LLTLLL!!LLLLLLLL!!!!LLL");
-	Codon64["CTC"] = Codon("R", "2", "LLTLLL!!LLLLLLLL!!!!LLL");
-
-	Codon64["AGA"] = Codon("D", "3", "R*RRSR!!SRRRGSRR!!!!SRR");
-	Codon64["AGG"] = Codon("D", "3", "R*RRSR!!SRRRGSRR!!!!SRR");
-	Codon64["AGT"] = Codon("D", "3", "SSSSSS!!SSSSSSSS!!!!SSS");
-	Codon64["AGC"] = Codon("D", "3", "SSSSSS!!SSSSSSSS!!!!SSS");
-	Codon64["TGA"] = Codon("D", "3", "*WWWW*!!WC**WW**!!!!W**");
-	Codon64["TGG"] = Codon("D", "3", "WWWWWW!!WWWWWWWW!!!!WWW");
-	Codon64["TGT"] = Codon("D", "3", "CCCCCC!!CCCCCCCC!!!!CCC");
-	Codon64["TGC"] = Codon("D", "3", "CCCCCC!!CCCCCCCC!!!!CCC");
-	Codon64["ACA"] = Codon("R", "3", "TTTTTT!!TTTTTTTT!!!!TTT");
-	Codon64["ACG"] = Codon("R", "3", "TTTTTT!!TTTTTTTT!!!!TTT");
-	Codon64["ACT"] = Codon("R", "3", "TTTTTT!!TTTTTTTT!!!!TTT");
-	Codon64["ACC"] = Codon("R", "3", "TTTTTT!!TTTTTTTT!!!!TTT");
-	Codon64["TCA"] = Codon("R", "3", "SSSSSS!!SSSSSSSS!!!!S*S");
-	Codon64["TCG"] = Codon("R", "3", "SSSSSS!!SSSSSSSS!!!!SSS");
-	Codon64["TCT"] = Codon("R", "3", "SSSSSS!!SSSSSSSS!!!!SSS");
-	Codon64["TCC"] = Codon("R", "3", "SSSSSS!!SSSSSSSS!!!!SSS");
-
-	Codon64["GGA"] = Codon("R", "4", "GGGGGG!!GGGGGGGG!!!!GGG");
-	Codon64["GGG"] = Codon("R", "4", "GGGGGG!!GGGGGGGG!!!!GGG");
-	Codon64["GGT"] = Codon("R", "4", "GGGGGG!!GGGGGGGG!!!!GGG");
-	Codon64["GGC"] = Codon("R", "4", "GGGGGG!!GGGGGGGG!!!!GGG");
-	Codon64["CGA"] = Codon("R", "4", "RRRRRR!!RRRRRRRR!!!!RRR");
-	Codon64["CGG"] = Codon("R", "4", "RRRRRR!!RRRRRRRR!!!!RRR");
-	Codon64["CGT"] = Codon("R", "4", "RRRRRR!!RRRRRRRR!!!!RRR");
-	Codon64["CGC"] = Codon("R", "4", "RRRRRR!!RRRRRRRR!!!!RRR");
-	Codon64["GCA"] = Codon("R", "4", "AAAAAA!!AAAAAAAA!!!!AAA");
-	Codon64["GCG"] = Codon("R", "4", "AAAAAA!!AAAAAAAA!!!!AAA");
-	Codon64["GCT"] = Codon("R", "4", "AAAAAA!!AAAAAAAA!!!!AAA");
-	Codon64["GCC"] = Codon("R", "4", "AAAAAA!!AAAAAAAA!!!!AAA");
-	Codon64["CCA"] = Codon("R", "4", "PPPPPP!!PPPPPPPP!!!!PPP");
-	Codon64["CCG"] = Codon("R", "4", "PPPPPP!!PPPPPPPP!!!!PPP");
-	Codon64["CCT"] = Codon("R", "4", "PPPPPP!!PPPPPPPP!!!!PPP");
-	Codon64["CCC"] = Codon("R", "4", "PPPPPP!!PPPPPPPP!!!!PPP"); 
-        
+}
+
+//Constructor function
+Base::Base(): Base(Context()) {
+}
+
+Base::Base(const Context &c): ctx(c) {
 
+	int i;
 	for(i=0; i<5; i++) {
 		Si[i] = Vi[i] = L[i] = NULL;
 	}
@@ -167,11 +158,96 @@ Base::Base() {
 * Return Value: void
 * Note: flag = "\t" (default) or "\n"
 *********************************************/
-void Base::addString(string &result, string str, string flag) {
+void Base::addString(string &result, const string &str, const char *flag) {
 	result += str;
 	result += flag;
 }
 
+void Base::addNumber(string &result, double value, const char *flag) {
+	appendNumber(result, value);
+	result += flag;
+}
+
+void Base::addNumber(string &result, unsigned long value, const char *flag) {
+	appendNumber(result, value);
+	result += flag;
+}
+
+/*********************************************
+* Function: appendNumber
+* Input Parameter: string, double
+* Output: Append the value as "%g" writes it: 6 significant
+		  digits, in fixed notation from 1e-4 to 1e6 and with
+		  trailing zeros removed.
+* Return Value: void
+* Note: The digits are scaled by an exact power of 10 and
+		rounded, unless the value is too close to a tie to
+		round as "%g" does, or needs an exponent, in which
+		cases it is left to snprintf.
+*********************************************/
+void appendNumber(string &result, double value) {
+
+	static const double pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+
+	char buf[32], *p = buf;
+	double a = fabs(value);
+	long long n = -1;
+	int e = 0;
+
+	if (a >= 1e-4 && a < 1e6) {
+		//Exponent of the first significant digit
+		e = (int)floor(log10(a));
+		if (e < 5 && a >= (e >= -1 ? pow10[e + 1] : 1 / pow10[-e - 1])) e++;
+		if (e > -4 && a < (e >= 0 ? pow10[e] : 1 / pow10[-e])) e--;
+
+		//Six digits, unless rounding half way
+		double s = a * pow10[5 - e], f = s - floor(s);
+		if (fabs(f - 0.5) > 1e-6) {
+			n = (long long)floor(s + 0.5);
+			if (n == 1000000) {
+				n = 100000;
+				e++;
+			}
+			if (e > 5) n = -1;
+		}
+	}
+
+	if (n < 0) {
+		snprintf(buf, sizeof(buf), "%g", value);
+		result += buf;
+		return;
+	}
+
+	char digits[6];
+	int i, last = 5;
+	for (i = 5; i >= 0; i--, n /= 10) digits[i] = '0' + n % 10;
+	while (last > 0 && last > e && digits[last] == '0') last--;
+
+	if (value < 0) *p++ = '-';
+	if (e < 0) {
+		*p++ = '0';
+		*p++ = '.';
+		for (i = -1; i > e; i--) *p++ = '0';
+		for (i = 0; i <= last; i++) *p++ = digits[i];
+	}
+	else {
+		for (i = 0; i <= e; i++) *p++ = digits[i];
+		if (last > e) *p++ = '.';
+		for (; i <= last; i++) *p++ = digits[i];
+	}
+	result.append(buf, p - buf);
+}
+
+void appendNumber(string &result, unsigned long value) {
+
+	char buf[24], *p = buf + sizeof(buf);
+	do {
+		*--p = '0' + value % 10;
+		value /= 10;
+	} while (value > 0);
+	result.append(p, buf + sizeof(buf) - p);
+}
+
 /**********************************************************************
 * Function: getAminoAcid
 * Input Parameter: codon or codon's id
@@ -179,10 +255,32 @@ void Base::addString(string &result, string str, string flag) {
 * Return Value: char 
 ***********************************************************************/
 char Base::getAminoAcid(string codon) {
-	return transl_table[2*(genetic_code-1)][getID(codon)];
+	return transl_table[2*(ctx.genetic_code-1)][getID(codon)];
 }
 char Base::getAminoAcid(int id) {
-	return transl_table[2*(genetic_code-1)][id];
+	return transl_table[2*(ctx.genetic_code-1)][id];
+}
+
+/****************************************************
+* Function: getCodonTable
+* Input Parameter: int
+* Output: Build the table of a genetic code the first time
+		  it is asked for, once for all threads.
+* Return Value: CodonTable
+*****************************************************/
+const CodonTable &Base::getCodonTable(int genetic_code) {
+
+	static CodonTable tables[NCODE];
+	static once_flag built[NCODE];
+
+	CodonTable &table = tables[genetic_code-1];
+	call_once(built[genetic_code-1], [&table, genetic_code]() { table.build(genetic_code); });
+
+	return table;
+}
+
+const CodonTable &Base::codonTable() {
+	return getCodonTable(ctx.genetic_code);
 }
 
 /**********************************
@@ -211,6 +309,10 @@ int Base::getID(string codon) {
 	return (convertChar(codon[0])*XSIZE + convertChar(codon[1])*DNASIZE + convertChar(codon[2]));
 }
 
+int Base::getID(const char *codon) {
+	return (convertChar(codon[0])*XSIZE + convertChar(codon[1])*DNASIZE + convertChar(codon[2]));
+}
+
 /********************************************
 * Function: getCodon
 * Input Parameter: int
@@ -220,15 +322,7 @@ int Base::getID(string codon) {
 *********************************************/
 string Base::getCodon(int IDcodon) {
 	
-	string codon = "TTT";
-
-	if (IDcodon>=0 && IDcodon<64) {
-		codon[0]=convertInt(IDcodon/16); 
-		codon[1]=convertInt((IDcodon%16)/4);
-		codon[2]=convertInt(IDcodon%4);
-	}
-
-	return codon;
+	return (IDcodon>=0 && IDcodon<64) ? ID2Codon[IDcodon] : ID2Codon[0];
 }
 
 /*********************************************
@@ -450,15 +544,14 @@ bool Base::writeFile(string output_filename, const char* result) {
 }
 
 /* Get GCC of entire sequences GC[0] and of three codon positions GC[1,2,3] */
-void Base::getGCContent(string str, int cds) {
+void Base::getGCContent(const string &str, double GC[], int cds) {
 	int i, j;
 
 	initArray(GC, 4);
 	if (cds == 1) {
 		for (i = 0; i < str.length(); i += 3) {
-			string codon = str.substr(i, 3);
-			for (j = 0; j < 3; j++) {
-				if (codon[j] == 'G' || codon[j] == 'C') GC[j + 1]++;
+			for (j = 0; j < 3 && i + j < str.length(); j++) {
+				if (str[i + j] == 'G' || str[i + j] == 'C') GC[j + 1]++;
 			}
 		}
 		GC[0] = sumArray(GC, 4, 1) / str.length()*1.0;
@@ -476,13 +569,13 @@ void Base::getGCContent(string str, int cds) {
 
 /****************************************************
  * Function: readAXTSeq
- * Input Parameter: string
+ * Input Parameter: string, vector, vector, long long, unsigned long
  * Output: Read sequences and their names.
  * Return Value: True if succeed, otherwise false.
 
  * Note: Using axt file
  *****************************************************/
-bool Base::readAXTSeq(string filename, vector<string> &vec_names, vector<string> &vec_seqs) {
+bool Base::readAXTSeq(string filename, vector<string> &vec_names, vector<string> &vec_seqs, long long start, unsigned long count) {
 
 	bool flag = true;
 	vec_names.clear();
@@ -490,31 +583,22 @@ bool Base::readAXTSeq(string filename, vector<string> &vec_names, vector<string>
 
 	try {
 
-		ifstream is(filename.c_str());
-		if (!is) {
+		AXTReader axt;
+		if (!axt.open(filename)) {
 			cout << "Error in opening file..." << endl;
 			throw 1;
 		}
 
-		string temp = "";
-		int count = 0;
-		while (getline(is, temp, '\n')) {
-
-			string name = "", seq = "";
+		if (start > 0) axt.seek(start);
 
-			name = temp;
-
-			getline(is, temp, '\n');
-			while (temp != "") {
-				seq += temp;
-				getline(is, temp, '\n');
-			}
-
-			vec_names.push_back(name);
-			vec_seqs.push_back(seq);
+		AXTRecord rec;
+		while (vec_names.size() < count && axt.next(rec)) {
+			vec_names.push_back(string(rec.name));
+			vec_seqs.push_back("");
+			rec.join(vec_seqs.back());
 		}
-		is.close();
-		is.clear();
+		if (axt.isFailed()) throw 1;
+		axt.close();
 
 	}
 	catch (...) {
@@ -584,6 +668,99 @@ bool Base::checkPairwiseCoding(string &str, string &msg) {
 	return flag;
 }
 
+/**************************************************
+ * Function: countCodonPairs
+ * Input Parameter: string, string, CodonPairCounts
+ * Output: Count each pair of codons at the same position
+ *         of two sequences of valid codons.
+ * Return Value: void
+ ***************************************************/
+void Base::countCodonPairs(const string &seq1, const string &seq2, CodonPairCounts &counts) {
+
+	int index[CODON*CODON];
+
+	memset(counts.count, 0, sizeof(counts.count));
+	counts.pairs.clear();
+	counts.positions.clear();
+
+	const char *s1 = seq1.c_str(), *s2 = seq2.c_str();
+	for (long i=0; i+3<=seq1.length() && i+3<=seq2.length(); i+=3) {
+		int k = getID(s1+i)*CODON + getID(s2+i);
+		if (counts.count[k]++ == 0) {
+			index[k] = counts.pairs.size();
+			counts.pairs.push_back(k);
+		}
+		counts.positions.push_back(index[k]);
+	}
+}
+
+SharedStages *Base::getStages(const string &seq1, const string &seq2) {
+	return ctx.stages != NULL && ctx.stages->isPair(seq1, seq2) ? ctx.stages : NULL;
+}
+
+const CodonPairCounts &Base::getCodonPairs(const string &seq1, const string &seq2, CodonPairCounts &counts) {
+
+	SharedStages *stages = getStages(seq1, seq2);
+	if (stages == NULL) {
+		countCodonPairs(seq1, seq2, counts);
+		return counts;
+	}
+
+	if (!stages->counted) {
+		countCodonPairs(seq1, seq2, stages->counts);
+		stages->counted = true;
+	}
+
+	return stages->counts;
+}
+
+/**************************************************
+ * Function: filterCodons
+ * Input Parameter: string_view, string_view, string, string
+ * Output: Copy the codons of a pair into seq1 and seq2 in
+ *         uppercase, except those with a gap or an unknown
+ *         base in either sequence, or a stop codon.
+ * Return Value: void
+ *
+ * Note: One pass over the views, instead of deleting the
+ *       codons from copies of the sequences one by one.
+ ***************************************************/
+void Base::filterCodons(string_view str1, string_view str2, string &seq1, string &seq2) {
+
+	char codon1[3], codon2[3];
+	bool found;
+	long i, j;
+
+	seq1 = seq2 = "";
+	seq1.reserve(str1.length());
+	seq2.reserve(str2.length());
+
+	for (i = 0; i + 3 <= str1.length() && i + 3 <= str2.length(); i += 3) {
+		for (found = false, j = 0; j < 3 && !found; j++) {
+			if (str1[i + j] == '-' || str2[i + j] == '-') {
+				found = true;
+			}
+			codon1[j] = toupper(str1[i + j]);
+			codon2[j] = toupper(str2[i + j]);
+			if (convertChar(codon1[j]) == -1 || convertChar(codon2[j]) == -1) {
+				found = true;
+			}
+		}
+
+		//Stop codon
+		if (!found) {
+			int id1 = convertChar(codon1[0]) * XSIZE + convertChar(codon1[1]) * DNASIZE + convertChar(codon1[2]);
+			int id2 = convertChar(codon2[0]) * XSIZE + convertChar(codon2[1]) * DNASIZE + convertChar(codon2[2]);
+			found = (getAminoAcid(id1) == '!' || getAminoAcid(id2) == '!');
+		}
+
+		if (!found) {
+			seq1.append(codon1, 3);
+			seq2.append(codon2, 3);
+		}
+	}
+}
+
 bool Base::checkPairwiseNoncoding(string seq, string &msg) {
 	bool flag = true;
 
@@ -603,8 +780,79 @@ bool Base::checkPairwiseNoncoding(string seq, string &msg) {
 /*****************************************************
 * Function: parseOutput
 * Input Parameter: void
-* Output: Parse estimated results for outputing
+* Output: Parse estimated results for outputing, or keep
+		  them in the rows of context without formatting.
 * Return Value: string
+******************************************************/		
+string Base::parseOutput() {
+
+	ResultRow row;
+	getRow(row);
+
+	//Rows are formatted later, if at all
+	if (ctx.rows != NULL) {
+		ctx.rows->push_back(row);
+		return "";
+	}
+
+	string result;
+	result.reserve(256);
+	formatRow(row, result);
+
+	return result;
+}
+
+/*****************************************************
+* Function: getRow
+* Input Parameter: ResultRow
+* Output: Get the estimated results for a row of output,
+		  with the p-value of Fisher's test if it is shown.
+* Return Value: void
+******************************************************/
+void Base::getRow(ResultRow &row) {
+
+	row.seq_name = ctx.seq_name;
+	row.method = name;
+	row.model = model;
+	row.length = ctx.length;
+
+	row.Ka = Ka;
+	row.Ks = Ks;
+	row.S = S;
+	row.N = N;
+	row.Sd = Sd;
+	row.Nd = Nd;
+	row.snp = snp;
+	row.t = t;
+	row.lnL = lnL;
+	row.AICc = AICc;
+	row.AkaikeWeight = AkaikeWeight;
+
+	//Fisher's test: p_value
+	if (Sd<SMALLVALUE || Nd<SMALLVALUE || S<SMALLVALUE || N<SMALLVALUE) row.P = NA;
+	else row.P = fisher(Sd,Nd,S-Sd,N-Nd);
+
+	//0-fold, 2-fold and 4-fold
+	for (int i=0; i<3; i++) {
+		row.L[i] = L[2*i];
+		row.Si[i] = Si[2*i];
+		row.Vi[i] = Vi[2*i];
+	}
+	for (int i=0; i<NUMBER_OF_RATES; i++) row.KAPPA[i] = KAPPA[i];
+	for (int i=0; i<4; i++) row.GC[i] = ctx.GC[i];
+
+/*
+	//Standard Errors
+	SEKa, SEKs
+*/
+}
+
+/*****************************************************
+* Function: formatRow
+* Input Parameter: ResultRow, string
+* Output: Append the row to 'result', values not available
+		  as "NA".
+* Return Value: void
 
   Order: "Sequence", "Method", "Ka", "Ks", "Ka/Ks", 
 		 "P-Value(Fisher)", "Length", "S-Sites", "N-Sites", "Fold-Sites(0:2:4)",
@@ -612,184 +860,120 @@ bool Base::checkPairwiseNoncoding(string seq, string &msg) {
 		 "Divergence-Time", "Substitution-Rate-Ratio(rTC:rAG:rTA:rCG:rTG:rCA/rCA)", "GC(1:2:3)", "ML-Score", "AICc",
 		 "Model"
 ******************************************************/		
-string Base::parseOutput() {
-
-	int i;
-	string result = "", tmp;
+void Base::formatRow(const ResultRow &row, string &result) {
+
+	//Numbers are appended in place, like CONVERT<string>
+	auto addValue = [&result](bool na, double value) {
+		if (na) result += "NA";
+		else appendNumber(result, value);
+		result += '\t';
+	};
+	auto addList = [&result](const double values[], int n) {
+		for (int k = 0; k < n; k++) {
+			if (k > 0) result += ':';
+			appendNumber(result, values[k]);
+		}
+	};
 
 	//Sequence name
-	addString(result, seq_name);
+	result += row.seq_name;		result += '\t';
 	//Method name
-	addString(result, name);
+	result += row.method;		result += '\t';
 
 	//Ka
-	if (Ka<SMALLVALUE) {
-		tmp = "NA";
-	}
-	else {
-		tmp = CONVERT<string>(Ka);
-	}
-	addString(result, tmp);
-	
+	addValue(row.Ka<SMALLVALUE, row.Ka);
 	//Ks
-	if (Ks<SMALLVALUE) {
-		tmp = "NA";
-	}
-	else {
-		tmp = CONVERT<string>(Ks);
-	}
-	addString(result, tmp);
-	
+	addValue(row.Ks<SMALLVALUE, row.Ks);
 	//Ka/Ks
-	if(Ks<SMALLVALUE || Ks==NA || Ka==NA) {
-		tmp = "NA";
-	}
-	else {
-		tmp = CONVERT<string>(Ka/Ks);
-	}
-	addString(result, tmp);
+	addValue(row.Ks<SMALLVALUE || row.Ks==NA || row.Ka==NA, row.Ka/row.Ks);
 
 	//Fisher's test: p_value
-	if (Sd<SMALLVALUE || Nd<SMALLVALUE || S<SMALLVALUE || N<SMALLVALUE)
-		tmp = "NA";
-	else {
-		tmp = CONVERT<string>(fisher(Sd,Nd,S-Sd,N-Nd));
-	}
-	addString(result, tmp);
+	addValue(row.Sd<SMALLVALUE || row.Nd<SMALLVALUE || row.S<SMALLVALUE || row.N<SMALLVALUE, row.P);
 
 	//Length of compared pairwise sequences
-	addString(result, CONVERT<string>(length));
-	
-	//Synonymous(S) sites
-	if (S<SMALLVALUE) {
-		tmp = "NA";
-	}
-	else {
-		tmp = CONVERT<string>(S);
-	}
-	addString(result, tmp);
+	appendNumber(result, row.length);	result += '\t';
 
+	//Synonymous(S) sites
+	addValue(row.S<SMALLVALUE, row.S);
 	//Nonsynonymous(N) sites
-	if (N<SMALLVALUE) {
-		tmp = "NA";
-	}
-	else {
-		tmp = CONVERT<string>(N);
-	}
-	addString(result, tmp);
+	addValue(row.N<SMALLVALUE, row.N);
 
 	//L[0], L[2], L[4] only for Prof.Li's series(LWL85, LPB93...)
-	if (L[0]<SMALLVALUE && L[2]<SMALLVALUE && L[4]<SMALLVALUE) {
-		tmp = "NA";		
-	}
-	else {		
-		tmp = CONVERT<string>(L[0]);	tmp += ":";
-		tmp += CONVERT<string>(L[2]);	tmp += ":";
-		tmp += CONVERT<string>(L[4]);		
-	}
-	addString(result, tmp);
+	if (row.L[0]<SMALLVALUE && row.L[1]<SMALLVALUE && row.L[2]<SMALLVALUE) result += "NA";
+	else addList(row.L, 3);
+	result += '\t';
 
-	
 	//Substitutions
-	addString(result, CONVERT<string>(snp));
+	addValue(false, row.snp);
 
-	//Sysnonymous(Sd) Substitutions(Nd)	
-	if (Sd>SMALLVALUE) {
-		tmp = CONVERT<string>(Sd);		
-	}	
-	else {
-		tmp = "NA";
-	}
-	addString(result, tmp);
-	
+	//Sysnonymous(Sd) Substitutions(Nd)
+	addValue(!(row.Sd>SMALLVALUE), row.Sd);
 	//Nonsysnonymous Substitutions(Nd)
-	if (Nd>SMALLVALUE) {
-		tmp = CONVERT<string>(Nd);		
-	}	
-	else {
-		tmp = "NA";
-	}
-	addString(result, tmp);
+	addValue(!(row.Nd>SMALLVALUE), row.Nd);
 
 	//Si for Li's series' methods(LWL85, LPB93...)
-	if (Si[0]!=NULL || Si[2]!=NULL || Si[4]!=NULL) { //Si[0], Si[2], Si[4]
-		tmp  = CONVERT<string>(Si[0]);	tmp += ":";
-		tmp += CONVERT<string>(Si[2]);	tmp += ":";
-		tmp += CONVERT<string>(Si[4]);		
-	}
-	else {
-		tmp = "NA";
-	}
-	addString(result, tmp);
+	if (row.Si[0]!=0 || row.Si[1]!=0 || row.Si[2]!=0) addList(row.Si, 3);
+	else result += "NA";
+	result += '\t';
 
 	//Vi for Li's series' methods(LWL85, LPB93...)
-	if (Vi[0]!=NULL || Vi[2]!=NULL || Vi[4]!=NULL) { //Vi[0], Vi[2], Vi[4]
-		tmp  = CONVERT<string>(Vi[0]);	tmp += ":";
-		tmp += CONVERT<string>(Vi[2]);	tmp += ":";
-		tmp += CONVERT<string>(Vi[4]);		
-	}
-	else {
-		tmp = "NA";
-	}
-	addString(result, tmp);
-
+	if (row.Vi[0]!=0 || row.Vi[1]!=0 || row.Vi[2]!=0) addList(row.Vi, 3);
+	else result += "NA";
+	result += '\t';
 
 	//Divergence time or distance t = (S*Ks+N*Ka)/(S+N)
-	if(t<SMALLVALUE) {
-		tmp = "NA";
-	}
-	else {
-		tmp = CONVERT<string>(t);
-	}
-	addString(result, tmp);
+	addValue(row.t<SMALLVALUE, row.t);
 
 	//Substitution-Rate-Ratio(rTC:rAG:rTA:rCG:rTG:rCA/rCA)
-	for(i=0, tmp=""; i<NUMBER_OF_RATES-1; i++) {
-		tmp += CONVERT<string>(KAPPA[i]); 
-		tmp += ":";
-	}
-	tmp += CONVERT<string>(KAPPA[i]); 
-	addString(result, tmp);
+	addList(row.KAPPA, NUMBER_OF_RATES);
+	result += '\t';
 
 	//GC Content
-	tmp  = CONVERT<string>(GC[0]);	tmp += "(";
-	tmp += CONVERT<string>(GC[1]);	tmp += ":";
-	tmp += CONVERT<string>(GC[2]);	tmp += ":";
-	tmp += CONVERT<string>(GC[3]);	tmp += ")";
-	addString(result, tmp);
-	
+	appendNumber(result, row.GC[0]);	result += '(';
+	addList(row.GC + 1, 3);			result += ")\t";
+
 	//Maximum Likelihood Value
-	if (lnL==NA) tmp = "NA";
-	else         tmp = CONVERT<string>(lnL);
-	addString(result, tmp);
-	
+	addValue(row.lnL==NA, row.lnL);
 	//AICc
-	if (AICc==NA) tmp = "NA";
-	else		  tmp = CONVERT<string>(AICc);
-	addString(result, tmp);
-
+	addValue(row.AICc==NA, row.AICc);
 	//Akaike weight in model selection
-	if (AkaikeWeight==NA) tmp = "NA";
-	else		  tmp = CONVERT<string>(AkaikeWeight);
-	addString(result, tmp);
-	
+	addValue(row.AkaikeWeight==NA, row.AkaikeWeight);
+
 	//Selected Model according to AICc
-	if (model==""||model.length()==0) tmp = "NA";
-	else tmp = model;
-	addString(result, tmp, "\n");
+	if (row.model==""||row.model.length()==0) result += "NA";
+	else result += row.model;
+	result += '\n';
+}
 
-/*
-	//Standard Errors
-	if (SEKa==NA) tmp = "NA";
-	else tmp = CONVERT<string>(SEKa);
-	addString(result, tmp, "\t");
-	
-	if (SEKs==NA) tmp = "NA";
-	else tmp = CONVERT<string>(SEKs);
-	addString(result, tmp, "\n");
-*/
-	
-	return result;
+/* Values in the order of the columns: Ka, Ks, P, S, N, L, snp, Sd, Nd, Si, Vi, t, KAPPA, GC, lnL, AICc, AkaikeWeight */
+void Base::getValues(const ResultRow &row, double values[]) {
+
+	int i, k = 0;
+	values[k++] = row.Ka;	values[k++] = row.Ks;	values[k++] = row.P;
+	values[k++] = row.S;	values[k++] = row.N;
+	for (i=0; i<3; i++) values[k++] = row.L[i];
+	values[k++] = row.snp;	values[k++] = row.Sd;	values[k++] = row.Nd;
+	for (i=0; i<3; i++) values[k++] = row.Si[i];
+	for (i=0; i<3; i++) values[k++] = row.Vi[i];
+	values[k++] = row.t;
+	for (i=0; i<NUMBER_OF_RATES; i++) values[k++] = row.KAPPA[i];
+	for (i=0; i<4; i++) values[k++] = row.GC[i];
+	values[k++] = row.lnL;	values[k++] = row.AICc;	values[k++] = row.AkaikeWeight;
+}
+
+void Base::setValues(ResultRow &row, const double values[]) {
+
+	int i, k = 0;
+	row.Ka = values[k++];	row.Ks = values[k++];	row.P = values[k++];
+	row.S = values[k++];	row.N = values[k++];
+	for (i=0; i<3; i++) row.L[i] = values[k++];
+	row.snp = values[k++];	row.Sd = values[k++];	row.Nd = values[k++];
+	for (i=0; i<3; i++) row.Si[i] = values[k++];
+	for (i=0; i<3; i++) row.Vi[i] = values[k++];
+	row.t = values[k++];
+	for (i=0; i<NUMBER_OF_RATES; i++) row.KAPPA[i] = values[k++];
+	for (i=0; i<4; i++) row.GC[i] = values[k++];
+	row.lnL = values[k++];	row.AICc = values[k++];	row.AkaikeWeight = values[k++];
 }
 
 /**************************************************
@@ -57,12 +57,14 @@
 
 /* Stanard lib of C++ */
 #include<string>
+#include<string_view>
 #include<iostream>
 #include<sstream>
 #include<fstream>
 #include<vector>
 #include<map>
 #include<stdlib.h>
+#include<stdio.h>
 #include<math.h>
 #include<time.h>
 #include<string.h>
@@ -72,14 +74,35 @@ using namespace std;
 
 /*****Global variables*****/
 extern const char* transl_table[];	//Genetic codon table
-extern int genetic_code;			//ID of codon table from 1 to 33
 extern int GeneticCode[][64];
-
-extern string seq_name;				//Pairwise sequences' name
-extern unsigned long length;		//Length of compared sequences
-extern double GC[4];				//GC Contents of entire sequences(GC[0]) and three codon positions (GC[1--3])
 //End of Global variables
 
+/* Results of a method on a pair, the values of a row of output before formatting */
+struct ResultRow {
+	string seq_name, method, model;
+	unsigned long length;
+	double Ka, Ks, P, S, N, L[3], snp, Sd, Nd, Si[3], Vi[3], t;
+	double KAPPA[NUMBER_OF_RATES], GC[4], lnL, AICc, AkaikeWeight;
+};
+/* Number of the values of type double in a row, from Ka to AkaikeWeight */
+#define RESULT_VALUES 31
+
+struct SharedStages;
+
+/* Context of a computation on a pair, passed to the methods for calculating Ka and Ks */
+struct Context {
+	Context(): length(0), genetic_code(1), rows(NULL), stages(NULL) {
+		GC[0] = GC[1] = GC[2] = GC[3] = 0.0;
+	}
+
+	string seq_name;		//Pairwise sequences' name
+	unsigned long length;	//Length of compared sequences
+	double GC[4];			//GC Contents of entire sequences(GC[0]) and three codon positions (GC[1--3])
+	int genetic_code;		//ID of codon table from 1 to 33
+	vector<ResultRow> *rows;	//Rows kept instead of formatted ones, if not NULL
+	SharedStages *stages;	//Intermediate results shared by the methods on the pair, if not NULL
+};
+
 
 /* Convert one type to any other type */
 template<class out_type,class in_value>
@@ -94,35 +117,65 @@ template<class out_type,class in_value>
 		return result;
 	}
 
-class Codon {
-	
-public:
-	Codon() {}
-	
-	Codon(string RorD, string q, string aa="") {
-		RobDiv = RorD;
-		Quarter = q;
-	}
-	/* Robustness or Diversity */
-	string RobDiv;
-	/* Quarter Location: 1:low gc, 2:gc p1, 3:gc p2, 4:high gc */
-	string Quarter;
-	/* Amino acid */
-	string aa;
+/* Append a number as written into a stream by default, i.e. as "%g" with 6 significant
+   digits, without a stream or a temporary string */
+void appendNumber(string &result, double value);
+void appendNumber(string &result, unsigned long value);
+
+/* Properties of a codon, the same in all genetic codes */
+struct Codon {
+	/* Robustness or Diversity: 'R' or 'D' */
+	char RobDiv;
+	/* Quarter Location: '1':low gc, '2':gc p1, '3':gc p2, '4':high gc */
+	char Quarter;
 };
 
-typedef map<int, string> IntString;
-typedef map<string, int> StringInt;
-typedef map<string, Codon> StringCodon;
+/* Changes of a codon at a position to another base */
+#define CHANGE_SAME 0		//Not changed
+#define CHANGE_SYN 1		//Synonymous
+#define CHANGE_NONSYN 2		//Nonsynonymous
+#define CHANGE_STOP 3		//Into a stop codon
+
+/* Facts of the codons in a genetic code, looked up by the methods instead
+   of changing codons and translating them for every pair */
+struct CodonTable {
+	/* Amino acid, '!' for a stop codon */
+	char aa[CODON];
+	/* Change of a codon at a position to a base (T,C,A,G as 0~3) */
+	char change[CODON][CODONLENGTH][DNASIZE];
+	/* Numbers of synonymous changes and changes into a stop codon at a position */
+	int syn[CODON][CODONLENGTH], stop[CODON][CODONLENGTH];
+	/* 0, 2 or 4-fold degenerate at a position, by the synonymous changes */
+	int fold[CODON][CODONLENGTH];
+	/* No change at a position gives the same amino acid */
+	bool nondegenerate[CODON][CODONLENGTH];
+	/* Every change at the third position gives the same amino acid */
+	bool fourfold[CODON];
+
+	/* Fill the table for a genetic code */
+	void build(int genetic_code);
+};
+
+/* Histogram of the pairs of codons at the same positions of two sequences,
+   for methods summing the contributions of codon pairs */
+struct CodonPairCounts {
+	/* Count of each pair, by id1*CODON+id2 */
+	unsigned int count[CODON*CODON];
+	/* Pairs found, in the order of their first appearance */
+	vector<int> pairs;
+	/* Index into 'pairs' of the pair at each position, for sums in the order of the codons */
+	vector<int> positions;
+};
 
 
 class Base {
 
 public:
 	Base();
+	Base(const Context &c);
 
-	/* Read seqeunces and their names */
-	bool readAXTSeq(string filename, vector<string> &vec_names, vector<string> &vec_seqs);
+	/* Read seqeunces and their names, at most 'count' records from byte offset 'start' */
+	bool readAXTSeq(string filename, vector<string> &vec_names, vector<string> &vec_seqs, long long start=0, unsigned long count=(unsigned long)-1);
 	/* Write the content into file */
 	bool writeFile(string output_filename, const char* result);
 
@@ -130,11 +183,30 @@ public:
 	bool checkPairwiseNoncoding(string seq, string &msg); 
 	/* Check pairwise coding sequences valid or not */
 	bool checkPairwiseCoding(string &seq, string &msg);
-
-	/* Parse results */
+	/* Keep the codons of a pair without gaps, unknown bases or stop codons, in uppercase */
+	void filterCodons(string_view str1, string_view str2, string &seq1, string &seq2);
+	/* Count the pairs of codons of two sequences in one pass */
+	void countCodonPairs(const string &seq1, const string &seq2, CodonPairCounts &counts);
+	/* Stages shared on the pair in the context, or NULL if the sequences are not the pair's */
+	SharedStages *getStages(const string &seq1, const string &seq2);
+	/* Pairs of codons of two sequences, counted once for all methods if they are the
+	   pair's, otherwise into 'counts' */
+	const CodonPairCounts &getCodonPairs(const string &seq1, const string &seq2, CodonPairCounts &counts);
+
+	/* Parse results, as a row of text or into the rows of context */
 	string parseOutput();	
+	/* Get the values of the results */
+	void getRow(ResultRow &row);
+	/* Format the values of a row, as written into file */
+	static void formatRow(const ResultRow &row, string &result);
+	/* Get the values of a row in the order of the columns, or set them */
+	static void getValues(const ResultRow &row, double values[]);
+	static void setValues(ResultRow &row, const double values[]);
 	/* Format string for outputing into file */
-	void addString(string &result, string str, string flag="\t");
+	void addString(string &result, const string &str, const char *flag="\t");
+	/* Format a number for outputing into file, as CONVERT<string> does */
+	void addNumber(string &result, double value, const char *flag="\t");
+	void addNumber(string &result, unsigned long value, const char *flag="\t");
 
 	/* Generate a radnom integer */
 	int getRandom();
@@ -155,10 +227,12 @@ public:
 
 	/* Return the codon's id from codon table */
 	int getID(string codon);
+	/* Return the id of three bases */
+	int getID(const char *codon);
 	/* Return a codon according to the id */
 	string getCodon(int IDcodon);
 	/* Get GCC of entire sequences and of three codon positions */
-	void getGCContent(string str, int cds=1);
+	void getGCContent(const string &str, double GC[], int cds=1);
 
 	/* Sum array's elements */
 	double sumArray(double x[], int end, int begin=0);
@@ -186,6 +260,9 @@ public:
 
 
 public:
+	/* Context of the computation, including the pair's name, length, GC and genetic code */
+	Context ctx;
+
 	/* Name of method for calculating ka/ks */
 	string name;
 	/* Sysnonymous sites(S) and nonsysnonymous sites(N) */
@@ -226,20 +303,70 @@ public:
 
 	/* Store Maximum Likilhood results for Model Selection and Model Averaging */
 	struct MLResult {
-		string result;	//estimated results
+		ResultRow row;	//estimated results
 		double AICc;	//the value of a modified AIC
 		double freq[CODON];		//Codon frequency
 		double rate[NUMBER_OF_RATES];	//Six substitution rates
 		double w;	//Ka/Ks
 		double t;	//divergence distance
 	};
-        
-	//ID(1~64) to Codon
-	IntString ID2Codon;
-	//Codon to ID
-	StringInt Codon2ID;
-        //64 Codons
-	StringCodon Codon64;	
+
+	/* Table of a genetic code, built once when first asked for and shared by all objects */
+	static const CodonTable &getCodonTable(int genetic_code);
+	/* Table of the genetic code in the context */
+	const CodonTable &codonTable();
+
+	/* Tables of codons, built at compile time and shared by all objects.
+	   A codon's id is given by 'getID' */
+	//ID(0~63) to Codon
+	static const char ID2Codon[CODON][4];
+	//64 Codons by ID
+	static const Codon Codon64[CODON];
+};
+
+/* Intermediate results of a pair shared by several methods. Each stage
+   is computed by the first method needing it, in the order the methods
+   are run, and taken over by the others. The stages belong to the
+   sequences of the pair: a method given any other sequences, even equal
+   ones, computes its own results */
+struct SharedStages {
+	SharedStages(const string &s1, const string &s2): seq1(&s1), seq2(&s2), counted(false), fitted(false) {
+		ng.done = lwl[0].done = lwl[1].done = yn.done = false;
+	}
+
+	/* Whether the sequences are those of the pair */
+	bool isPair(const string &s1, const string &s2) const {
+		return &s1 == seq1 && &s2 == seq2;
+	}
+	bool isPair(const char *s1, const char *s2) const {
+		return s1 == seq1->c_str() && s2 == seq2->c_str();
+	}
+
+	/* Sequences of the pair */
+	const string *seq1, *seq2;
+
+	/* Histogram of the pairs of codons: NG, LWL and YN methods */
+	bool counted;
+	CodonPairCounts counts;
+	/* Sites and differences: NONE and NG */
+	struct {
+		bool done;
+		double S, N, Sd, Nd, snp;
+	} ng;
+	/* Sums of sites and differences: LWL and LPB (0), MLWL and MLPB (1) */
+	struct {
+		bool done;
+		double L[5], Si[5], Vi[5], snp;
+	} lwl[2];
+	/* Codon frequencies: YN and MYN */
+	struct {
+		bool done;
+		double f12pos[3*DNASIZE], pi[CODON], pi_sqrt[CODON];
+		int npi0;
+	} yn;
+	/* Fit of GY under the model HKY, a candidate of MS */
+	bool fitted;
+	Base::MLResult gy;
 };
 
 #endif